@@ -0,0 +1,54 @@
+#pragma once
+#include "buffer_pool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 批量读取的单个文件。data 借自 BufferPool::instance()，重复传入同一组 BatchFile 时容量够用就沿用，
+// 也可以把 data 移交给 FileView 等持有者，用完归还到池中
+struct BatchFile {
+    PooledBuffer data;
+    size_t size{0};
+    bool ok{false};
+
+    std::string_view view() const { return std::string_view(data.data(), size); }
+};
+
+// 大量小文件的批量读取。逐个读取时每个文件都要 stat、open、fstat、read、close 各一次系统调用；
+// io_uring 后端把一批文件的 openat + statx、read、close 各作为一轮提交，每轮只需一次 io_uring_enter。
+// 编译环境有 <linux/io_uring.h> 且运行时 io_uring_setup 成功（内核支持、未被禁用）时使用 io_uring，
+// 否则（或运行中遇到不支持的操作码）回退到在调用线程上逐个 open/fstat/read/close，接口与结果相同。
+class BatchReader {
+  public:
+    explicit BatchReader(size_t batch_size = 64, bool allow_io_uring = true);
+    ~BatchReader();
+
+    BatchReader(const BatchReader&) = delete;
+    BatchReader& operator=(const BatchReader&) = delete;
+
+    bool uses_io_uring() const { return ring_ != nullptr; }
+    size_t batch_size() const { return batch_size_; }
+
+    // 读取 paths[0, count)，count 超过 batch_size() 时分批进行；out[k] 对应 paths[k]，读失败时 ok 为 false
+    void read(const std::string* paths, size_t count, BatchFile* out);
+
+    // 本对象发出的系统调用次数（含回退路径），用于与逐个读取对比
+    size_t syscall_count() const { return syscalls_.load(); }
+
+  private:
+    struct Ring;
+
+    void read_batch_ring(const std::string* paths, size_t count, BatchFile* out);
+    void read_batch_fallback(const std::string* paths, size_t count, BatchFile* out);
+
+    size_t batch_size_;
+    std::unique_ptr<Ring> ring_;
+    std::atomic<size_t> syscalls_{0};
+};
+
+// 是否编译进了 io_uring 支持（运行时是否可用见 BatchReader::uses_io_uring）
+bool io_uring_compiled();
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class BufferPool;
+
+// 从 BufferPool 借出的缓冲区：内容未初始化，容量按大小级向上取整；析构（或 reset）时归还给所属的池
+class PooledBuffer {
+  public:
+    PooledBuffer() = default;
+    ~PooledBuffer() { reset(); }
+    PooledBuffer(PooledBuffer&& other) noexcept { *this = std::move(other); }
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* data() const { return data_; }
+    size_t capacity() const { return capacity_; }
+    explicit operator bool() const { return data_ != nullptr; }
+    void reset();
+
+  private:
+    friend class BufferPool;
+
+    BufferPool* owner_{nullptr};
+    char* data_{nullptr};
+    size_t capacity_{0};
+};
+
+struct BufferPoolStats {
+    size_t allocations{0};  // 向系统申请新内存的次数
+    size_t reuses{0};       // 直接复用空闲缓冲区的次数
+    size_t live{0};         // 当前借出的缓冲区数
+    size_t peak_live{0};    // 借出数的峰值
+    size_t cached{0};       // 池中空闲的缓冲区数
+    size_t cached_bytes{0};
+};
+
+// 小文件读取缓冲区池。大小级为 4 KiB 到 8 MiB 的 2 的幂（与 mmap 阈值对应），借出时不清零；
+// 归还后按大小级缓存，空闲总量超过 max_cached_bytes 时直接释放，超过最大级的请求按原大小分配且不缓存。
+// 借出与归还常在不同线程（读取线程借、匹配线程还），因此用一个全局池而不是线程私有的 arena，
+// 每次借还只持锁做一次链表操作，相对一次文件读取可以忽略。
+class BufferPool {
+  public:
+    static constexpr size_t kMinClassBytes = size_t(4) << 10;
+    static constexpr size_t kMaxClassBytes = size_t(8) << 20;
+
+    explicit BufferPool(size_t max_cached_bytes = size_t(64) << 20);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    static BufferPool& instance();
+
+    // 借出容量不小于 size 的缓冲区（size 为 0 时返回空缓冲区）
+    PooledBuffer acquire(size_t size);
+
+    BufferPoolStats stats() const;
+    void reset_stats();  // 计数清零（live 与空闲缓冲区不变，peak_live 重置为当前 live）
+    void trim();         // 释放全部空闲缓冲区
+
+  private:
+    friend class PooledBuffer;
+
+    static size_t class_index(size_t size);
+    void release(char* data, size_t capacity);
+
+    size_t max_cached_bytes_;
+    mutable std::mutex mutex_;
+    std::vector<std::vector<char*>> free_;  // 每个大小级的空闲缓冲区
+    BufferPoolStats stats_;
+};
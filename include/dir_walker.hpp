@@ -0,0 +1,57 @@
+#pragma once
+#include "thread_pool.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 遍历得到的普通文件。order 为从根目录起各级目录项在 readdir 中的序号，按字典序比较即为
+// 串行递归遍历（recursive_directory_iterator）的先序顺序，用于在并行遍历后恢复确定的输出顺序。
+struct WalkEntry {
+    std::string path;
+    std::vector<std::uint32_t> order;
+};
+
+bool walk_order_less(const WalkEntry& a, const WalkEntry& b);
+
+// 并行目录遍历：每个目录一个线程池任务，按 readdir 的 d_type 区分文件与目录，只有类型未知或为符号链接时才 stat
+// （与 recursive_directory_iterator 一致：跟随指向文件的链接，不进入指向目录的链接）。
+// 发现的文件进入有界队列，扫描线程通过 next 立即取用，遍历与匹配重叠进行。
+// 队列达到 capacity 时新的子目录暂缓派发，直到消费者取走文件；遍历任务从不阻塞线程池，
+// 因此消费者本身也可以是线程池任务。无法打开的目录直接跳过。
+class DirectoryWalker {
+  public:
+    explicit DirectoryWalker(const std::string& root, size_t capacity = 4096);
+    // 提前结束时停止派发新的目录，并等待已派发的任务结束
+    ~DirectoryWalker();
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    // 取下一个文件（顺序不确定）；遍历完成且队列为空时返回 false。可被多个线程同时调用，
+    // 等待期间只帮忙执行本遍历尚未开始的目录任务，没有时阻塞到有新文件或新目录任务
+    bool next(WalkEntry& entry);
+
+  private:
+    struct Directory {
+        std::string path;
+        std::vector<std::uint32_t> order;
+    };
+
+    void visit(const Directory& dir);
+    // 持锁调用：队列未满时计入 active_ 并放入 launch，否则暂缓
+    void schedule(Directory dir, std::vector<Directory>& launch);
+    void launch(std::vector<Directory>& dirs);
+
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<WalkEntry> files_;
+    std::vector<Directory> deferred_;
+    size_t active_{0};  // 已派发但尚未结束的目录任务
+    bool stop_{false};
+    TaskGroup group_;
+};
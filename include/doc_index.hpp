@@ -0,0 +1,48 @@
+#pragma once
+#include "index_file.hpp"
+#include "matcher.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 文档后缀数组索引：对（去掉 '\r' 后的）文档构建一次，保存到磁盘后跨运行复用。
+// 查询在后缀数组上二分出以模式串为前缀的后缀区间，代价 O(m log n + occ log occ)，与文档长度近似无关。
+// 索引文件同时保存规范化后的文本，加载后无需再读取原文档。后缀下标为 32 位，文档需小于 4 GiB。
+class SuffixArrayIndex {
+  public:
+    SuffixArrayIndex() = default;
+
+    // 前缀倍增构建：先按前 7 字节并行分段排序后归并，之后每轮只对仍并列的组按 rank[i+k] 细分（组间并行）
+    static SuffixArrayIndex build(std::string_view text, int num_threads);
+
+    // 索引文件记录源文档的大小与修改时间，加载时不一致视为过期，返回 false
+    bool save(const std::string& path, std::uint64_t source_size, std::int64_t source_mtime) const;
+    bool load(const std::string& path, std::uint64_t source_size, std::int64_t source_mtime);
+
+    bool empty() const { return sa_ == nullptr; }
+    size_t size() const { return text_.size(); }
+    std::string_view text() const { return text_; }
+
+    // 全部出现位置（0-based，升序），格式与 match_parallel 一致
+    std::vector<MatchPos> find(std::string_view pattern) const;
+    size_t count(std::string_view pattern) const;
+
+  private:
+    // 以 pattern 为前缀的后缀在 sa_ 中的区间 [first, last)
+    std::pair<size_t, size_t> equal_range(std::string_view pattern) const;
+
+    std::vector<char> owned_text_;  // build 得到的文本；移动后缓冲区地址不变，text_ 保持有效
+    std::vector<std::uint32_t> owned_sa_;
+    IndexFile file_;  // load 映射的索引文件，text_ / sa_ 直接指向其中
+    std::string_view text_;
+    const std::uint32_t* sa_{nullptr};
+};
+
+// 文档索引保存在 <doc_path>.sa，源文件状态由 file_stat 取得
+std::string doc_index_path(const std::string& doc_path);
+
+// 读取并规范化 doc_path，构建索引并保存；成功返回 true
+bool build_doc_index(const std::string& doc_path, int num_threads);
@@ -1,5 +1,7 @@
 #pragma once 
+#include "result_writer.hpp"
 #include <string> 
 #include <vector>
 
-void run_doc_search(const std::string& input_dir, const std::string& output_path, int num_threads);
+void run_doc_search(const std::string& input_dir, const std::string& output_path, int num_threads,
+                    ResultFormat format = ResultFormat::Text);
@@ -0,0 +1,99 @@
+#pragma once
+#include "utils.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class FilePrefetcher;
+
+// 预读好的一个文件：持有 FileView，析构（或 reset）时把其字节数从在途总量中扣除，让读取线程继续
+class PrefetchedFile {
+  public:
+    PrefetchedFile() = default;
+    ~PrefetchedFile() { reset(); }
+    PrefetchedFile(PrefetchedFile&& other) noexcept { *this = std::move(other); }
+    PrefetchedFile& operator=(PrefetchedFile&& other) noexcept;
+
+    PrefetchedFile(const PrefetchedFile&) = delete;
+    PrefetchedFile& operator=(const PrefetchedFile&) = delete;
+
+    size_t index() const { return index_; }  // 在构造 FilePrefetcher 的 paths 中的下标
+    std::string_view view() const { return file_.view; }
+    void reset();
+
+  private:
+    friend class FilePrefetcher;
+
+    FilePrefetcher* owner_{nullptr};
+    size_t index_{0};
+    size_t bytes_{0};
+    FileView file_;
+};
+
+// 读取阶段与匹配阶段重叠：专用读取线程按 paths 的顺序读入文件，并对之后 lookahead 个文件提前发出
+// posix_fadvise(WILLNEED)；大文件映射时加 MAP_POPULATE / MADV_SEQUENTIAL，由读取线程承担缺页等待。
+// 读好的文件经队列交给匹配线程。已读入但尚未被消费者释放的字节数超过 max_inflight_bytes 时读取暂停，
+// 内存占用有上界（单个文件超过上限时在没有其他在途文件时照常读取）。
+// 读取线程每次领取 batch_files 个连续文件，其中小于 mmap_threshold 的连续文件经 BatchReader 成批读取
+// （可用时走 io_uring），在途额度按批计入。
+// 读取线程只做 IO，从不向线程池提交或等待线程池任务，所以消费者（可以是线程池任务）在 next 中阻塞等待即可。
+class FilePrefetcher {
+  public:
+    struct Options {
+        size_t max_inflight_bytes = size_t(256) << 20;
+        size_t lookahead = 16;  // 提前发出 WILLNEED 的文件数
+        int readers = 1;        // 读取线程数，存储支持并发 IO 时可以调大
+        size_t mmap_threshold = 8 * 1024 * 1024;
+        bool populate = true;
+        size_t batch_files = 32;  // 每次领取的文件数，其中的小文件成批读取；1 为逐个读取
+    };
+
+    explicit FilePrefetcher(std::vector<std::string> paths);
+    FilePrefetcher(std::vector<std::string> paths, Options options);
+    // 调用方已知各文件大小（如已为排序 stat 过）时传入 sizes（与 paths 一一对应），读取线程不再逐个 stat
+    FilePrefetcher(std::vector<std::string> paths, std::vector<size_t> sizes);
+    FilePrefetcher(std::vector<std::string> paths, std::vector<size_t> sizes, Options options);
+    // 提前结束时停止读取并等待读取线程退出；已交出的 PrefetchedFile 需先于本对象销毁
+    ~FilePrefetcher();
+
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+    // 取下一个读好的文件（按读完的先后）；全部取完返回 false。可被多个线程同时调用
+    bool next(PrefetchedFile& file);
+
+    size_t inflight_bytes() const;
+
+  private:
+    friend class PrefetchedFile;
+
+    struct Ready {
+        size_t index;
+        size_t bytes;
+        FileView file;
+    };
+
+    void reader_loop();
+    void release(size_t bytes);
+
+    std::vector<std::string> paths_;
+    std::vector<size_t> sizes_;  // 为空时由读取线程 stat
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable space_cv_;  // 在途字节数下降
+    std::condition_variable ready_cv_;  // 有新文件读好或全部读完
+    std::deque<Ready> ready_;
+    size_t next_path_{0};      // 下一个待读的下标
+    size_t advised_{0};        // 已发出 WILLNEED 的下标上界
+    size_t inflight_{0};
+    size_t readers_running_{0};
+    bool stop_{false};
+    std::vector<std::thread> readers_;
+};
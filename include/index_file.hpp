@@ -0,0 +1,113 @@
+#pragma once
+#include "utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 只读数组视图：指向构建得到的 vector 或映射进来的索引文件，不拥有内存
+template <typename T> class ConstSpan {
+  public:
+    ConstSpan() = default;
+    ConstSpan(const T* data, size_t size) : data_(data), size_(size) {}
+    ConstSpan(const std::vector<T>& v) : data_(v.data()), size_(v.size()) {}
+
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+  private:
+    const T* data_{nullptr};
+    size_t size_{0};
+};
+
+// 可直接 mmap 使用的索引文件格式（所有整数按写入机器的字节序）：
+//   IndexFileHeader（64 字节）| IndexSection × section_count | 各 section 数据（起点 64 字节对齐）
+// section 以四字符 tag 标识，用相对文件开头的偏移代替指针，映射后即可按数组直接访问，无需解析或重建。
+// header 校验和覆盖 header 与 section 表，打开时检查；各 section 的数据校验和只在 verify 时检查，
+// 因此打开多 GB 的索引也只需一次 mmap。只读映射的页在多个进程之间共享同一份页缓存。
+struct IndexFileHeader {
+    char magic[8];                // "PSMINDEX"
+    std::uint32_t version;        // 格式版本，不一致拒绝打开
+    std::uint32_t kind;           // 文件用途（文档索引 / 特征集合等），防止误用
+    std::uint32_t endian;         // kIndexEndianMark，字节序不同的机器拒绝打开
+    std::uint32_t section_count;
+    std::uint64_t file_size;
+    std::uint64_t checksum;       // header（本字段置 0）与 section 表的校验和
+    std::uint64_t reserved[3];
+};
+
+struct IndexSection {
+    std::uint32_t tag;
+    std::uint32_t elem_size;  // 元素字节数，读取数组时核对
+    std::uint64_t offset;     // 相对文件开头，64 字节对齐
+    std::uint64_t size;       // 字节数
+    std::uint64_t checksum;   // 数据校验和
+};
+
+constexpr std::uint32_t kIndexFormatVersion = 1;
+constexpr std::uint32_t kIndexEndianMark = 0x01020304;
+
+// 四字符 tag，例如 index_tag("TEXT")
+constexpr std::uint32_t index_tag(const char (&s)[5]) {
+    return std::uint32_t((unsigned char)s[0]) | std::uint32_t((unsigned char)s[1]) << 8 |
+           std::uint32_t((unsigned char)s[2]) << 16 | std::uint32_t((unsigned char)s[3]) << 24;
+}
+
+std::uint64_t index_checksum(const void* data, size_t size);
+
+// 收集 section 后一次写出。add 只记录指针，数据需在 write 之前保持有效。
+// 先写到临时文件再改名，正在映射旧文件的进程不受影响。
+class IndexWriter {
+  public:
+    explicit IndexWriter(std::uint32_t kind) : kind_(kind) {}
+
+    void add(std::uint32_t tag, const void* data, size_t size, std::uint32_t elem_size = 1);
+    template <typename T> void add_array(std::uint32_t tag, ConstSpan<T> values) {
+        add(tag, values.data(), values.size() * sizeof(T), sizeof(T));
+    }
+
+    bool write(const std::string& path) const;
+
+  private:
+    struct Pending {
+        std::uint32_t tag;
+        std::uint32_t elem_size;
+        const void* data;
+        size_t size;
+    };
+
+    std::uint32_t kind_;
+    std::vector<Pending> sections_;
+};
+
+class IndexFile {
+  public:
+    // 映射并检查 header；verify_data 为 true 时同时检查各 section 的数据校验和
+    bool open(const std::string& path, std::uint32_t kind, bool verify_data = false);
+    bool is_open() const { return !file_.view.empty(); }
+    bool verify() const;
+
+    bool has(std::uint32_t tag) const { return find(tag) != nullptr; }
+    // section 不存在时返回 false；数组还要求元素大小一致且按元素对齐
+    bool bytes(std::uint32_t tag, std::string_view& out) const;
+    template <typename T> bool array(std::uint32_t tag, ConstSpan<T>& out) const {
+        const IndexSection* section = find(tag);
+        if (section == nullptr || section->elem_size != sizeof(T) || section->size % sizeof(T) != 0) return false;
+        const char* ptr = file_.view.data() + section->offset;
+        if (reinterpret_cast<std::uintptr_t>(ptr) % alignof(T) != 0) return false;
+        out = ConstSpan<T>(reinterpret_cast<const T*>(ptr), section->size / sizeof(T));
+        return true;
+    }
+
+  private:
+    const IndexFileHeader* header() const { return reinterpret_cast<const IndexFileHeader*>(file_.view.data()); }
+    const IndexSection* find(std::uint32_t tag) const;
+
+    FileView file_;
+};
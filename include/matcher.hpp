@@ -1,67 +1,374 @@
 #pragma once
+#include "index_file.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// 匹配位置（0-based 字节偏移）。统一使用 64 位，支持超过 2 GiB 的文档与二进制文件；
+// FindFirst 等接口以 -1 表示未命中。
+using MatchPos = std::int64_t;
+
+// 并行匹配的分块粒度（字节）：文本切成多个该大小的块（各自向右拓展 pattern_len-1），
+// 由至多 num_threads 个任务从原子游标动态领取。默认 1 MiB，传 0 恢复默认值。
+void set_match_chunk_size(size_t bytes);
+size_t match_chunk_size();
+
+// 命中回调：每个命中位置调用一次，回调返回 false 时停止（返回 void 视为继续）。
+// 只保存可调用对象的地址，不复制、不分配，可调用对象需在本次匹配调用期间有效。
+class MatchVisitor {
+  public:
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, MatchVisitor>::value &&
+                                                      std::is_invocable<std::remove_reference_t<F>&, MatchPos>::value>>
+    MatchVisitor(F&& fn)
+        : ctx_(const_cast<void*>(static_cast<const void*>(&fn))), call_(&invoke<std::remove_reference_t<F>>) {}
+
+    bool operator()(MatchPos pos) const { return call_(ctx_, pos); }
+
+  private:
+    template <typename F> static bool invoke(void* ctx, MatchPos pos) {
+        F& fn = *static_cast<F*>(ctx);
+        if constexpr (std::is_void<decltype(fn(pos))>::value) {
+            fn(pos);
+            return true;
+        } else {
+            return static_cast<bool>(fn(pos));
+        }
+    }
+
+    void* ctx_;
+    bool (*call_)(void*, MatchPos);
+};
+
+// 单模式匹配算法；Auto 在编译模式串时按长度与熵选择具体算法（见 tuning.hpp）。
+// ShiftOr / BNDM 为位并行算法，BOM 为基于 factor oracle 的后向匹配；三者处理模式串的前 128 字节，
+// 更长的模式串在前缀命中后比较剩余部分。TwoWay（Crochemore–Perrin）最坏情况线性、只需常数额外空间，
+// 适合可能遇到高度重复输入（如 "aaaa…"）的场景
+enum class MatchAlgo { BF, KMP, Sunday, RK, BM, SIMD, ShiftOr, BNDM, BOM, TwoWay, Auto };
+
+// 预编译模式串：按算法构建一次预处理表（KMP 的 lps、Sunday 的位移表、BM 的坏字符与逐位置好后缀位移、
+// RK 的模式哈希、ShiftOr / BNDM 的字节位掩码、BOM 的 factor oracle、TwoWay 的临界分解），
+// 表存放在扁平数组中。编译后只读，可在多个线程、多个文件之间共享。
+class CompiledPattern {
+  public:
+    CompiledPattern() = default;
+    CompiledPattern(std::string_view pattern, MatchAlgo algo);
+
+    MatchAlgo algo() const { return algo_; }
+    std::string_view pattern() const { return pattern_; }
+    size_t size() const { return pattern_.size(); }
+
+    std::vector<MatchPos> match(std::string_view text) const;
+    // 把 text 中的命中位置加上 offset 后追加到 positions
+    void match(std::string_view text, MatchPos offset, std::vector<MatchPos>& positions) const;
+    // 只计数，不生成位置数组
+    size_t count(std::string_view text) const;
+    // 第一个命中位置，没有命中返回 -1；找到后立即停止扫描
+    MatchPos find_first(std::string_view text) const;
+    // 按位置升序把命中（加上 offset）交给 visit，不生成中间数组
+    void for_each(std::string_view text, MatchPos offset, MatchVisitor visit) const;
+    // 把命中写入调用方预先分配的 out[0, capacity)，写满即停止，返回写入个数
+    size_t match_into(std::string_view text, MatchPos offset, MatchPos* out, size_t capacity) const;
+    // 前 capacity 个命中写入 head，其余追加到 rest，返回命中总数（用于先写定长暂存区、只有密集时才分配的场合）
+    size_t match_split(std::string_view text, MatchPos offset, MatchPos* head, size_t capacity,
+                       std::vector<MatchPos>& rest) const;
+
+  private:
+    // 内核把每个命中交给 sink，sink 返回 false 时停止扫描
+    template <typename Sink> void scan(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_bf(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_kmp(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_sunday(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_rk(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_bm(std::string_view text, MatchPos offset, Sink& sink) const;
+    template <typename Sink> void scan_two_way(std::string_view text, MatchPos offset, Sink& sink) const;
+
+    MatchAlgo algo_{MatchAlgo::BF};
+    std::string pattern_;
+    std::vector<int> table_;
+    std::vector<std::uint64_t> masks_;  // ShiftOr / BNDM：每字节 1 个（窗口 <= 64）或 2 个 64 位字
+    std::vector<std::uint8_t> oracle_;  // BOM：(窗口 + 1) × 256 的转移表
+    unsigned long long hash_{0};
+    unsigned long long power_{1};
+    MatchPos period_{1};     // BM：模式串最小周期（命中后的位移）；TwoWay：命中或左半部分失配后的位移
+    MatchPos critical_{-1};  // TwoWay：临界分解位置（左半部分的最后一个下标，可为 -1）
+    bool periodic_{false};   // TwoWay：左半部分是否在 period_ 下与右半部分一致（需要记住已匹配前缀）
+};
+
+// 使用预编译模式串的并行匹配（文本 / 二进制）。每块只向右多扫描 m-1 字节，命中起点不会越出本块，
+// 各块结果互不重复且块内升序，按块顺序拼接即全局有序，无需排序去重
+std::vector<MatchPos> match_parallel(std::string_view text, const CompiledPattern& pattern, int num_threads);
+// 把命中追加到调用方持有的 positions（多次调用可复用其容量）：各块命中先写入共享暂存区（只有密集块另行分配），
+// 按前缀和一次性扩容后并行拷贝到最终位置，返回追加个数
+size_t match_parallel(std::string_view text, const CompiledPattern& pattern, int num_threads,
+                      std::vector<MatchPos>& positions);
+// 在调用线程上按位置升序依次回调 visit，visit 无需线程安全：按块顺序分轮并行扫描，只暂存本轮其余各块的命中；
+// visit 返回 false 时停止回调，尚在扫描的块随之停下，之后的块不再扫描
+void match_parallel(std::string_view text, const CompiledPattern& pattern, int num_threads, MatchVisitor visit);
+std::vector<MatchPos> binary_match_parallel(std::string_view text, const CompiledPattern& pattern, int num_threads);
+
+// 多个单模式的分块执行：文本切成约 L2 大小的块（match_tile_size），num_threads 个工作者各负责连续的一段块，
+// 每块依次跑完全部模式串再处理下一块，文本每块只从内存读入一次，而不是每个模式串整篇扫描一遍。
+// 返回值第 k 项与 match_parallel(text, patterns[k], ...) 的结果相同
+std::vector<std::vector<MatchPos>> match_parallel_tiled(std::string_view text,
+                                                        const std::vector<CompiledPattern>& patterns, int num_threads);
+// 分块执行的块大小（字节），默认取 L2 容量的一半（无法获取时 256 KiB），传 0 恢复默认值
+void set_match_tile_size(size_t bytes);
+size_t match_tile_size();
+
+// 一组模式串在同一文本上的批量匹配，并行方式：
+// Patterns  每个模式串一个任务，各自串行扫描整篇文本（文本小、模式串多时，不受单模式 n / m 并发上限限制）
+// Text      按文本分块：match_parallel_tiled，各工作者负责一段块并在块内跑完全部模式串（文本大时）
+// Both      模式串之间并行，每个模式串再按文本分块并行，二者的并发度相乘不超过 num_threads
+// Auto      按文本大小（choose_threads）与模式串数选择，见 choose_batch_strategy
+enum class BatchStrategy { Auto, Patterns, Text, Both };
+
+struct BatchOptions {
+    int num_threads{1};
+    BatchStrategy strategy{BatchStrategy::Auto};
+};
+
+// 返回值第 k 项为 patterns[k] 的全部命中（升序），与逐个 match_parallel 相同；并行任务都提交到共享线程池
+std::vector<std::vector<MatchPos>> match_batch(std::string_view text, const std::vector<CompiledPattern>& patterns,
+                                               const BatchOptions& options);
+// Auto 的实际选择：文本足够 num_threads 路并发时按文本分块；否则模式串不少于 num_threads 时按模式串并行，
+// 两者都不够时同时在模式串与文本两个维度并行
+BatchStrategy choose_batch_strategy(size_t text_size, size_t pattern_count, int num_threads);
+
+// 匹配模式：
+// All       收集全部位置（升序）
+// Count     只计数，不生成位置数组
+// FindFirst 只找第一个命中；任一块命中后通过共享原子上限让后续块不再扫描
+enum class MatchMode { All, Count, FindFirst };
+
+struct MatchResult {
+    size_t count{0};
+    std::vector<MatchPos> positions;  // All：全部位置；FindFirst：至多一个位置；Count：为空
+};
+
+MatchResult match_parallel(std::string_view text, const CompiledPattern& pattern, int num_threads, MatchMode mode);
+
+bool match_exists(std::string_view text, const CompiledPattern& pattern, int num_threads);
+size_t match_count(std::string_view text, const CompiledPattern& pattern, int num_threads);
+bool binary_match_exists(std::string_view text, const CompiledPattern& pattern, int num_threads);
+size_t binary_match_count(std::string_view text, const CompiledPattern& pattern, int num_threads);
+
 // string_view 版本（可零拷贝）
-std::vector<int> match_single(std::string_view text, std::string_view pattern);
-std::vector<int> match_single_bf(std::string_view text, std::string_view pattern);
-std::vector<int> match_single_kmp(std::string_view text, std::string_view pattern);
-std::vector<int> match_single_sunday(std::string_view text, std::string_view pattern);
-std::vector<int> match_single_rk(std::string_view text, std::string_view pattern);
-std::vector<int> match_single_bm(std::string_view text, std::string_view pattern);
-
-std::vector<int> match_parallel(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> match_parallel_bf(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> match_parallel_kmp(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> match_parallel_sunday(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> match_parallel_rk(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> match_parallel_bm(std::string_view text, std::string_view pattern, int num_threads);
+// *_simd：首字节 + 尾字节广播比较 16/32 字节块，只校验候选位；运行时选择 AVX2 / SSE2 / 可移植实现
+// 不带算法后缀的 match_single / match_parallel（及 binary_ 版本）自动选择算法，并行版本同时按文本大小决定线程数
+std::vector<MatchPos> match_single(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_bf(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_kmp(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_sunday(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_rk(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_bm(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_simd(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_shift_or(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_bndm(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_bom(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> match_single_two_way(std::string_view text, std::string_view pattern);
+
+std::vector<MatchPos> match_parallel(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bf(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_kmp(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_sunday(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_rk(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bm(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_simd(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_shift_or(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bndm(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bom(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> match_parallel_two_way(std::string_view text, std::string_view pattern, int num_threads);
 
 // 兼容旧接口（std::string 输入）
-std::vector<int> match_single(const std::string& text, const std::string& pattern);
-std::vector<int> match_single_bf(const std::string& text, const std::string& pattern);
-std::vector<int> match_single_kmp(const std::string& text, const std::string& pattern);
-std::vector<int> match_single_sunday(const std::string& text, const std::string& pattern);
-std::vector<int> match_single_rk(const std::string& text, const std::string& pattern);
-std::vector<int> match_single_bm(const std::string& text, const std::string& pattern);
-
-std::vector<int> match_parallel(const std::string& text, const std::string& pattern, int num_threads);
-std::vector<int> match_parallel_bf(const std::string& text, const std::string& pattern, int num_threads);
-std::vector<int> match_parallel_kmp(const std::string& text, const std::string& pattern, int num_threads);
-std::vector<int> match_parallel_sunday(const std::string& text, const std::string& pattern, int num_threads);
-std::vector<int> match_parallel_rk(const std::string& text, const std::string& pattern, int num_threads);
-std::vector<int> match_parallel_bm(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_single(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_bf(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_kmp(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_sunday(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_rk(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_bm(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_simd(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_shift_or(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_bndm(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_bom(const std::string& text, const std::string& pattern);
+std::vector<MatchPos> match_single_two_way(const std::string& text, const std::string& pattern);
+
+std::vector<MatchPos> match_parallel(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bf(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_kmp(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_sunday(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_rk(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bm(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_simd(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_shift_or(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bndm(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_bom(const std::string& text, const std::string& pattern, int num_threads);
+std::vector<MatchPos> match_parallel_two_way(const std::string& text, const std::string& pattern, int num_threads);
 
 // 二进制匹配（string_view 版本 + 兼容 vector 版本）
-std::vector<int> binary_match_single(std::string_view text, std::string_view pattern);
-std::vector<int> binary_match_single_kmp(std::string_view text, std::string_view pattern);
-std::vector<int> binary_match_single_sunday(std::string_view text, std::string_view pattern);
-std::vector<int> binary_match_single_rk(std::string_view text, std::string_view pattern);
-std::vector<int> binary_match_single_bm(std::string_view text, std::string_view pattern);
-
-std::vector<int> binary_match_parallel(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> binary_match_parallel_bf(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> binary_match_parallel_kmp(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> binary_match_parallel_sunday(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> binary_match_parallel_rk(std::string_view text, std::string_view pattern, int num_threads);
-std::vector<int> binary_match_parallel_bm(std::string_view text, std::string_view pattern, int num_threads);
-
-std::vector<int> binary_match_single(const std::vector<char>& text, const std::vector<char>& pattern);
-std::vector<int> binary_match_single_kmp(const std::vector<char>& text, const std::vector<char>& pattern);
-std::vector<int> binary_match_single_sunday(const std::vector<char>& text, const std::vector<char>& pattern);
-std::vector<int> binary_match_single_rk(const std::vector<char>& text, const std::vector<char>& pattern);
-std::vector<int> binary_match_single_bm(const std::vector<char>& text, const std::vector<char>& pattern);
-
-std::vector<int> binary_match_parallel(const std::vector<char>& text, const std::vector<char>& pattern,
-                                       int num_threads);
-std::vector<int> binary_match_parallel_bf(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads);
-std::vector<int> binary_match_parallel_kmp(const std::vector<char>& text, const std::vector<char>& pattern,
-                                           int num_threads);
-std::vector<int> binary_match_parallel_sunday(const std::vector<char>& text, const std::vector<char>& pattern,
-                                              int num_threads);
-std::vector<int> binary_match_parallel_rk(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads);
-std::vector<int> binary_match_parallel_bm(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads);
+std::vector<MatchPos> binary_match_single(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_kmp(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_sunday(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_rk(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_bm(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_simd(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_shift_or(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_bndm(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_bom(std::string_view text, std::string_view pattern);
+std::vector<MatchPos> binary_match_single_two_way(std::string_view text, std::string_view pattern);
+
+std::vector<MatchPos> binary_match_parallel(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_bf(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_kmp(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_sunday(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_rk(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_bm(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_simd(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_shift_or(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_bndm(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_bom(std::string_view text, std::string_view pattern, int num_threads);
+std::vector<MatchPos> binary_match_parallel_two_way(std::string_view text, std::string_view pattern, int num_threads);
+
+std::vector<MatchPos> binary_match_single(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_kmp(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_sunday(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_rk(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_bm(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_simd(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_shift_or(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_bndm(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_bom(const std::vector<char>& text, const std::vector<char>& pattern);
+std::vector<MatchPos> binary_match_single_two_way(const std::vector<char>& text, const std::vector<char>& pattern);
+
+std::vector<MatchPos> binary_match_parallel(const std::vector<char>& text, const std::vector<char>& pattern,
+                                            int num_threads);
+std::vector<MatchPos> binary_match_parallel_bf(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads);
+std::vector<MatchPos> binary_match_parallel_kmp(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                int num_threads);
+std::vector<MatchPos> binary_match_parallel_sunday(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                   int num_threads);
+std::vector<MatchPos> binary_match_parallel_rk(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads);
+std::vector<MatchPos> binary_match_parallel_bm(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads);
+std::vector<MatchPos> binary_match_parallel_simd(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                 int num_threads);
+std::vector<MatchPos> binary_match_parallel_shift_or(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                     int num_threads);
+std::vector<MatchPos> binary_match_parallel_bndm(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                 int num_threads);
+std::vector<MatchPos> binary_match_parallel_bom(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                int num_threads);
+std::vector<MatchPos> binary_match_parallel_two_way(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                    int num_threads);
+
+// 多模式匹配：Aho-Corasick 自动机
+// 所有模式串编译进同一个自动机，字节按出现情况压缩为等价类，转移表为 states * classes 的扁平数组。
+// 模式串按字节处理，文本与二进制通用；空串不参与匹配，重复模式串共享同一个终止状态。
+class AhoCorasick {
+  public:
+    AhoCorasick() = default;
+    explicit AhoCorasick(const std::vector<std::string>& patterns);
+    explicit AhoCorasick(const std::vector<std::string_view>& patterns);
+
+    void build(const std::vector<std::string_view>& patterns);
+
+    size_t pattern_count() const { return pattern_ids_.size(); }
+    size_t state_count() const { return depth_.size(); }
+    size_t max_pattern_length() const { return max_len_; }
+
+    // 返回值按输入模式串顺序排列，每个列表为升序的 0-based 起始位置
+    std::vector<std::vector<MatchPos>> match(std::string_view text) const;
+    // 单次并行扫描：按 match_chunk_size() 切块，每块向右拓展 max_pattern_length()-1，只保留起点落在本块内的命中
+    std::vector<std::vector<MatchPos>> match_parallel(std::string_view text, int num_threads) const;
+
+    // 只判断出现与否：返回在 text 中出现过的模式串输入下标（升序），全部出现后提前结束扫描
+    std::vector<int> find_present(std::string_view text, int num_threads) const;
+
+    // 流式扫描：从状态 state 继续扫描 chunk（chunk[0] 的绝对偏移为 base），命中按输入下标追加到 results，
+    // 返回扫描结束时的状态，供下一段继续（初始状态为 0）。results 的大小需为 pattern_count()
+    int scan_stream(int state, std::string_view chunk, MatchPos base,
+                    std::vector<std::vector<MatchPos>>& results) const;
+
+    // 单独保存 / 映射加载自动机；加载时校验数据校验和与各表取值范围，失败返回 false 且不改变当前对象
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // 编译好的表作为 section 写入索引文件 / 从已打开的索引文件直接引用（不复制），
+    // owner 需持有 file，保证表在本对象（及其拷贝）存活期间有效
+    void write_sections(IndexWriter& writer) const;
+    bool read_sections(const IndexFile& file, std::shared_ptr<const void> owner);
+
+  private:
+    using Hit = std::pair<int, MatchPos>;  // (去重后编号, 起点)
+
+    void scan_present(std::string_view text, size_t start, size_t end, std::atomic<unsigned char>* seen,
+                      std::atomic<size_t>& found) const;
+    void scan_range(std::string_view text, size_t start, size_t end, std::vector<Hit>& hits) const;
+    std::vector<std::vector<MatchPos>> gather_results(std::vector<std::vector<Hit>>& chunk_hits) const;
+    std::vector<std::vector<MatchPos>> expand_results(std::vector<std::vector<MatchPos>>& unique_results) const;
+
+    struct Tables;  // build 得到的各表
+
+    int num_classes_{0};
+    size_t max_len_{0};
+    unsigned char byte_class_[256]{};
+    // 表所在的内存：build 时为 Tables，从索引文件加载时为映射的文件；拷贝之间共享
+    std::shared_ptr<const void> storage_;
+    ConstSpan<int> next_;         // 扁平转移表，next_[state * num_classes_ + cls]
+    ConstSpan<int> depth_;        // 状态深度（= 对应前缀长度）
+    ConstSpan<int> term_;         // 在该状态结束的模式串（去重后编号），-1 表示无
+    ConstSpan<int> report_;       // 沿 fail 链第一个带输出的状态（含自身），-1 表示无
+    ConstSpan<int> out_link_;     // 沿 fail 链下一个带输出的真后缀状态，-1 表示无
+    ConstSpan<int> unique_len_;   // 去重后模式串的长度
+    ConstSpan<int> pattern_ids_;  // 输入下标 -> 去重后编号，-1 表示空串
+};
+
+// 少量短字面量的多模式匹配（Teddy）：字面量按前 k = min(3, 最短长度) 个字节排序后分进 8 个桶，
+// 每个前缀位置按字节的低 / 高半字节各建一张 16 项的桶位掩码表。扫描时对 16/32 字节块用 PSHUFB 查表，
+// k 个位置的结果相与即得每个起点可能命中的桶，再逐个比较桶内字面量确认。运行时按 CPU 特性选择
+// AVX2 / SSSE3 / 标量（按字节查合并后的表）实现，结果相同。8–64 个字面量时通常快于自动机，也快于逐个单模式扫描
+class TeddyMatcher {
+  public:
+    static constexpr size_t kBuckets = 8;
+    static constexpr size_t kMaxPrefix = 3;
+
+    TeddyMatcher() = default;
+    explicit TeddyMatcher(const std::vector<std::string_view>& literals);
+
+    // 空串不参与匹配；重复的字面量各自报告
+    void build(const std::vector<std::string_view>& literals);
+
+    size_t pattern_count() const { return lengths_.size(); }
+    size_t prefix_length() const { return prefix_; }
+
+    // 返回值按输入字面量顺序排列，每个列表为升序的 0-based 起始位置
+    std::vector<std::vector<MatchPos>> match(std::string_view text) const;
+    // 只判断出现与否：返回在 text 中出现过的字面量输入下标（升序）。按 match_chunk_size() 切块并行，
+    // 一个桶的字面量都已出现后不再校验该桶，全部出现后提前结束
+    std::vector<int> find_present(std::string_view text, int num_threads) const;
+
+  private:
+    // 扫描起点在 [start, end) 内的命中，按起点升序调用 visit(字面量下标, 起点)，visit 返回 false 时停止；
+    // active 为仍需校验的桶，visit 可以清除其中的位
+    template <typename Visit>
+    void scan(std::string_view text, size_t start, size_t end, const std::uint8_t& active, Visit& visit) const;
+    template <typename Visit>
+    bool verify(std::string_view text, size_t pos, unsigned buckets, Visit& visit) const;
+
+    size_t prefix_{0};
+    size_t max_len_{0};
+    std::uint8_t lo_[kMaxPrefix][16]{};          // 前缀第 j 个字节低半字节 -> 可能的桶
+    std::uint8_t hi_[kMaxPrefix][16]{};          // 前缀第 j 个字节高半字节 -> 可能的桶
+    std::uint8_t byte_mask_[kMaxPrefix][256]{};  // 标量实现：lo_ 与 hi_ 按整字节合并
+    std::vector<std::string> literals_;
+    std::vector<int> lengths_;       // 输入下标 -> 长度（0 表示空串）
+    std::vector<int> bucket_ids_;    // 按桶排列的字面量下标
+    std::vector<int> bucket_begin_;  // 桶 b 的字面量为 bucket_ids_[bucket_begin_[b], bucket_begin_[b + 1])
+};
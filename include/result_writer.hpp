@@ -0,0 +1,38 @@
+#pragma once
+#include "index_file.hpp"
+#include "matcher.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 位置列表的输出格式：
+// Text   每个列表一行 "count pos pos ..."（与 result_document.txt 一致）
+// Binary 索引文件格式（见 index_file.hpp），位置按差分 + varint 压缩，下游可直接 mmap 后按列表随机访问
+enum class ResultFormat { Text, Binary };
+
+// 写出位置列表（每个列表需升序）。大列表切成若干段，各段并行格式化到按轮复用的大缓冲区
+// （文本用 std::to_chars，二进制用差分 + varint），再按顺序以少量大块写出；按轮处理，内存与输出总量无关。
+bool write_position_lists(const std::string& path, const std::vector<std::vector<MatchPos>>& lists, int num_threads,
+                          ResultFormat format = ResultFormat::Text);
+
+// 整块写出已拼好的文本，失败返回 false
+bool write_text_file(const std::string& path, std::string_view data);
+
+// 读取 Binary 格式的结果文件：打开时只检查 header，各列表按需解码
+class PositionListFile {
+  public:
+    bool open(const std::string& path);
+
+    size_t size() const { return counts_.size(); }
+    size_t count(size_t list) const { return static_cast<size_t>(counts_[list]); }
+    // 解码第 list 个列表；数据损坏时返回 false
+    bool positions(size_t list, std::vector<MatchPos>& out) const;
+
+  private:
+    IndexFile file_;
+    ConstSpan<std::uint64_t> counts_;
+    ConstSpan<std::uint64_t> offsets_;  // 各列表在 data_ 中的字节范围，共 size()+1 项
+    std::string_view data_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "matcher.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 病毒特征集合：所有特征串编译进同一个 Aho-Corasick 自动机，按字节匹配（二进制安全）。
+// 对一个缓冲区只需扫描一次即可得到其中出现的全部特征，扫描代价与特征数量无关。
+// 特征数量在 tuning 的 teddy_max_patterns 以内时改用 Teddy 多字面量扫描（SIMD 半字节查表找候选再校验）；
+// 否则特征数量少于 multi_pattern_min 时逐个特征用自动选择的单模式内核判断是否出现。
+class SignatureSet {
+  public:
+    SignatureSet() = default;
+
+    // 递归读取目录下的所有特征文件，按路径排序后编译；空文件（或读失败）跳过。
+    // 目录旁存在与当前文件列表（路径、大小、修改时间）一致的索引 <dir>.idx 时直接映射加载，跳过读取与编译
+    static SignatureSet load_directory(const std::string& dir);
+    // 读取并编译目录，生成 <dir>.idx
+    static bool save_index(const std::string& dir);
+
+    // 特征名与特征串复制进内存（体积小），自动机的表直接引用映射的文件
+    bool save(const std::string& path, std::uint64_t fingerprint) const;
+    bool load(const std::string& path, std::uint64_t fingerprint);
+
+    void add(std::string name, std::string_view bytes);
+    // add 之后调用，编译自动机（或 Teddy、单模式内核）
+    void compile();
+
+    size_t size() const { return names_.size(); }
+    const std::string& name(size_t id) const { return names_[id]; }
+    std::string_view bytes(size_t id) const { return signatures_[id]; }
+
+    // 返回 buffer 中出现过的特征编号（升序）
+    std::vector<int> scan(std::string_view buffer, int num_threads = 1) const;
+
+  private:
+    // 特征较少时构建 Teddy 或逐个单模式内核；返回 false 表示应使用自动机
+    bool compile_small();
+
+    std::vector<std::string> names_;
+    std::vector<std::string> signatures_;
+    AhoCorasick automaton_;
+    TeddyMatcher teddy_;                     // 有字面量时走 Teddy 扫描
+    std::vector<CompiledPattern> compiled_;  // 非空时走逐个单模式扫描
+};
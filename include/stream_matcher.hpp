@@ -0,0 +1,58 @@
+#pragma once
+#include "matcher.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 流式匹配：输入按任意大小的分段依次 feed，命中以整个流中的绝对偏移报告。
+// 内存占用只与模式串长度有关（单模式保留上一段末尾 m-1 字节，多模式只保留自动机状态），与输入总长度无关，
+// 适合管道、套接字以及超过内存的文件。
+
+// 单模式流式匹配，复用 CompiledPattern 的各算法内核
+class StreamMatcher {
+  public:
+    explicit StreamMatcher(CompiledPattern pattern);
+    StreamMatcher(std::string_view pattern, MatchAlgo algo);
+
+    // 追加下一段输入，命中的绝对起始位置按升序追加到 positions
+    void feed(std::string_view chunk, std::vector<MatchPos>& positions);
+    // 回到流的开头
+    void reset();
+
+    const CompiledPattern& pattern() const { return pattern_; }
+    // 已经 feed 的总字节数
+    MatchPos consumed() const { return consumed_; }
+
+  private:
+    CompiledPattern pattern_;
+    std::string carry_;     // 上一段末尾至多 m-1 字节
+    std::string boundary_;  // carry_ + 本段开头至多 m-1 字节，跨段复用
+    MatchPos consumed_{0};
+};
+
+// 多模式流式匹配：在分段之间保留 Aho-Corasick 状态，automaton 需在本对象之后析构
+class AhoCorasickStream {
+  public:
+    explicit AhoCorasickStream(const AhoCorasick& automaton);
+
+    // 追加下一段输入，results 按输入模式串顺序排列（不足时补齐），各列表按绝对起始位置升序追加
+    void feed(std::string_view chunk, std::vector<std::vector<MatchPos>>& results);
+    void reset();
+
+    MatchPos consumed() const { return consumed_; }
+
+  private:
+    const AhoCorasick* automaton_;
+    int state_{0};
+    MatchPos consumed_{0};
+};
+
+// 以 buffer_size 大小的固定缓冲区把输入读到结尾（std::istream 或文件描述符，如管道/套接字）
+std::vector<MatchPos> match_stream(std::istream& in, const CompiledPattern& pattern, size_t buffer_size = 1 << 20);
+std::vector<MatchPos> match_stream(int fd, const CompiledPattern& pattern, size_t buffer_size = 1 << 20);
+
+std::vector<std::vector<MatchPos>> match_stream(std::istream& in, const AhoCorasick& automaton,
+                                                size_t buffer_size = 1 << 20);
+std::vector<std::vector<MatchPos>> match_stream(int fd, const AhoCorasick& automaton, size_t buffer_size = 1 << 20);
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 进程级 work-stealing 线程池：每个工作线程一个双端队列，自己从尾部取，空闲时从其他队列头部窃取。
+// 任务一般经 TaskGroup 提交；等待一组任务的线程（包括工作线程自身）只帮忙执行本组尚未开始的任务，
+// 因此嵌套并行不会死锁，等待一组短任务时也不会接手其他组的长任务（如外层逐文件循环）。
+class ThreadPool {
+  public:
+    explicit ThreadPool(int num_workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int worker_count() const { return static_cast<int>(workers_.size()); }
+
+    // 在工作线程内提交时放入本线程队列，否则轮转放入各工作线程队列
+    void submit(std::function<void()> task);
+
+    // 全局线程池，首次调用时按 configure_thread_pool 的设置创建
+    static ThreadPool& instance();
+
+  private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop_task(std::function<void()>& task);
+    void worker_loop(int index);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+};
+
+// 设置全局线程池的总并发度（含调用线程，工作线程数为 num_threads-1），需在首次使用线程池前调用。
+// num_threads <= 0 表示使用 std::thread::hardware_concurrency()；环境变量 PSM_POOL_THREADS 优先。
+// 线程池已创建时返回 false。
+bool configure_thread_pool(int num_threads);
+
+// 一组任务：run 放入本组队列，并在需要时向线程池提交执行本组任务的入口（至多工作线程数个）；wait 等待全部完成
+// （等待期间只帮忙执行本组的任务，没有可执行的任务时阻塞到最后一个任务完成时被唤醒），任务抛出的第一个异常在 wait 中重新抛出
+class TaskGroup {
+  public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::instance());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+
+    // 执行本组一个尚未开始的任务；没有时返回 false。供需要等待本组产出的调用方帮忙推进
+    bool try_run_one();
+    // 本组是否还有尚未开始的任务
+    bool has_pending() const;
+
+  private:
+    // 线程池中的入口持有 State，执行本组任务直到队列为空后注销；本对象销毁后残留的入口取不到任务，直接返回
+    struct State {
+        mutable std::mutex mutex;
+        std::condition_variable done_cv;  // 最后一个任务完成，或有新任务可帮忙执行
+        std::deque<std::function<void()>> tasks;
+        size_t remaining{0};  // 尚未完成的任务（含未开始的）
+        size_t entries{0};    // 已提交到线程池、尚未注销的入口数
+        std::exception_ptr error;
+    };
+
+    // 执行本组一个尚未开始的任务；retire 为 true（线程池中的入口）时，发现队列为空的同时注销该入口
+    static bool run_one(State& state, bool retire);
+
+    ThreadPool& pool_;
+    std::shared_ptr<State> state_;
+};
+
+// 并行执行 fn(0) ... fn(count-1)，调用线程执行 fn(0) 并等待其余任务
+void parallel_for(int count, const std::function<void(int)>& fn);
+
+// 动态调度：最多 parallelism 路并发，各路从共享原子游标领取下一个下标，直到 count 个任务全部领取完。
+// 若提供 limit，则下标 >= *limit 的任务不再派发；任务执行中可以调小 limit 让所有线程提前结束。
+void parallel_for_dynamic(size_t count, int parallelism, const std::function<void(size_t)>& fn,
+                          const std::atomic<size_t>* limit = nullptr);
@@ -0,0 +1,54 @@
+#pragma once
+#include "matcher.hpp"
+
+#include <string>
+#include <string_view>
+
+// 自适应算法选择（MatchAlgo::Auto 及默认入口 match_parallel / binary_match_parallel 使用）。
+// 阈值有内置默认值，也可由 calibrate_tuning 在本机快速测量后保存为配置文件，启动时加载。
+struct TuningConfig {
+    MatchAlgo short_algo{MatchAlgo::SIMD};      // 长度 < long_pattern 的模式串
+    MatchAlgo long_algo{MatchAlgo::SIMD};       // 长度 >= long_pattern 的模式串
+    MatchAlgo low_entropy_algo{MatchAlgo::BM};  // 字节熵 < low_entropy_bits 的模式串（首尾字节过滤效果差）
+    size_t long_pattern{32};
+    double low_entropy_bits{1.5};
+    size_t min_bytes_per_thread{256 << 10};  // 每路并发至少分到的文本字节数，不足时减少线程
+    size_t multi_pattern_min{16};            // 模式串不少于该数量时用 Aho-Corasick 一次扫描，否则逐个单模式扫描
+    size_t teddy_max_patterns{64};           // 病毒特征为 2 到该数量个时用 Teddy 一次扫描（优先于以上两者）
+};
+
+struct MatchStrategy {
+    MatchAlgo algo;
+    int threads;
+};
+
+// 当前生效的配置；set_tuning_config / load_tuning_config 需在开始匹配前调用
+const TuningConfig& tuning_config();
+void set_tuning_config(const TuningConfig& config);
+
+// 配置文件为 key=value 文本，# 开头为注释；文件不存在或无法解析时返回 false 并保持当前配置
+bool load_tuning_config(const std::string& path);
+bool save_tuning_config(const std::string& path, const TuningConfig& config);
+
+// 默认配置文件路径：环境变量 PSM_TUNING，未设置时为当前目录下的 psm_tuning.conf
+std::string default_tuning_path();
+
+// 在合成文本上测量各算法与并行开销（约数秒），返回测得的配置，不修改当前配置
+TuningConfig calibrate_tuning(int num_threads);
+
+// 模式串的字节熵（bit/字节），取值 [0, 8]
+double pattern_entropy(std::string_view pattern);
+
+// 按模式串长度与熵选择算法（MatchAlgo::Auto 编译时使用）
+MatchAlgo choose_algo(std::string_view pattern);
+// 按文本大小与可用线程数决定实际线程数：不超过 num_threads 与线程池并发度，每路至少 min_bytes_per_thread 字节
+int choose_threads(size_t text_size, int num_threads);
+// choose_algo + choose_threads
+MatchStrategy choose_strategy(std::string_view pattern, size_t text_size, int num_threads);
+
+// 模式串数量是否值得使用多模式自动机
+bool prefer_multi_pattern(size_t pattern_count);
+// 特征数量是否适合 Teddy 多字面量扫描
+bool prefer_teddy(size_t pattern_count);
+
+const char* algo_name(MatchAlgo algo);
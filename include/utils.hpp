@@ -1,5 +1,8 @@
 #pragma once
+#include "buffer_pool.hpp"
+
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <string_view>
@@ -12,6 +15,9 @@ std::vector<char> read_binary_file(const std::string& path);
 
 std::vector<std::string> list_all_files(const std::string& root_path);
 
+// 文件大小与修改时间（文件系统时钟的计数），用于判断索引是否过期；失败返回 false
+bool file_stat(const std::string& path, std::uint64_t& size, std::int64_t& mtime);
+
 double now();
 
 double now();
@@ -22,7 +28,7 @@ struct FileView {
     bool mapped{false};
     int fd{-1};
     void* mapping{nullptr};
-    std::vector<char> buffer;
+    PooledBuffer buffer;  // 小文件的内容，借自 BufferPool::instance()，析构时归还
 
     FileView() = default;
     ~FileView();
@@ -36,6 +42,25 @@ struct FileView {
 // 自动根据大小选择 mmap（大文件）或常规读（小文件），默认阈值 8MB。
 FileView read_file_view(const std::string& path, size_t mmap_threshold = 8 * 1024 * 1024);
 
+// 映射文件的访问提示：sequential 对映射调用 madvise(MADV_SEQUENTIAL)，内核加大预读并及早回收已读过的页；
+// populate 映射时加 MAP_POPULATE，由调用线程预先读入全部页并建立页表，之后的匹配线程不再缺页等待
+struct ReadHints {
+    bool sequential{false};
+    bool populate{false};
+};
+FileView read_file_view(const std::string& path, size_t mmap_threshold, ReadHints hints);
+
+// 通知内核即将读取整个文件（posix_fadvise POSIX_FADV_WILLNEED），后台异步预读，不等待完成
+void prefetch_file(const std::string& path);
+
+// 去掉 '\r' 后的文本（文档检索与文档索引共用的规范化）。view 不含 '\r' 时直接引用原始字节，不复制；
+// 否则 view 指向 buffer，由 num_threads 路并行压缩得到（每路先数出自身的 '\r'，按前缀和确定写入位置）
+struct NormalizedText {
+    std::string_view view;
+    PooledBuffer buffer;
+};
+NormalizedText strip_carriage_returns(std::string_view raw, int num_threads);
+
 template <typename Func, typename... Args> double time_it(Func func, Args&&... args) {
     double t0 = now();
     func(std::forward<Args>(args)...);
@@ -2,4 +2,10 @@
 #include <string>
 #include <vector>
 
-void run_virus_search(const std::string& input_dir, const std::string& output_path, int num_threads);
+// 多文件并行扫描的派发顺序（输出顺序不受影响）：
+// LargestFirst 遍历完成后按文件大小降序派发，负载均衡最好
+// Discovery    边遍历边扫描，适合遍历本身耗时较长（文件数极多）的目录树
+enum class ScanOrder { LargestFirst, Discovery };
+
+void run_virus_search(const std::string& input_dir, const std::string& output_path, int num_threads,
+                      ScanOrder order = ScanOrder::LargestFirst);
@@ -1,32 +1,91 @@
+#include "doc_index.hpp"
 #include "doc_search.hpp"
+#include "signature_set.hpp"
 #include "matcher.hpp"
+#include "thread_pool.hpp"
+#include "tuning.hpp"
 #include "utils.hpp"
 #include "virus_search.hpp"
 #include <filesystem>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "Please run the project by: ./myapp <input_data_dir> <output_dir> [num_threads]\n";
+    // 校准：./myapp --calibrate [config_path]，测量本机各算法与并行开销并写入配置文件
+    if (argc >= 2 && std::string(argv[1]) == "--calibrate") {
+        std::string config_path = (argc >= 3) ? argv[2] : default_tuning_path();
+        TuningConfig config = calibrate_tuning(static_cast<int>(std::thread::hardware_concurrency()));
+        if (!save_tuning_config(config_path, config)) return 1;
+        std::cout << "Tuning saved to " << config_path << ": short=" << algo_name(config.short_algo)
+                  << " long=" << algo_name(config.long_algo) << " low_entropy=" << algo_name(config.low_entropy_algo)
+                  << " min_bytes_per_thread=" << config.min_bytes_per_thread
+                  << " multi_pattern_min=" << config.multi_pattern_min
+                  << " teddy_max_patterns=" << config.teddy_max_patterns << "\n";
+        return 0;
+    }
+
+    // 建索引：./myapp --build-index <input_data_dir> [num_threads]，为 document.txt 生成后缀数组索引，
+    // 为 virus 特征目录生成编译好的特征集合
+    if (argc >= 3 && std::string(argv[1]) == "--build-index") {
+        int num_threads = (argc >= 4) ? std::stoi(argv[3]) : 10;
+        configure_thread_pool(num_threads);
+        std::string doc_path = std::string(argv[2]) + "/document_retrieval/document.txt";
+        bool ok = false;
+        double t = time_it([&]() { ok = build_doc_index(doc_path, num_threads); });
+        if (!ok) return 1;
+        std::cout << "Index saved to " << doc_index_path(doc_path) << " in " << t << "secs\n";
+
+        std::string virus_dir = std::string(argv[2]) + "/software_antivirus/virus";
+        t = time_it([&]() { ok = SignatureSet::save_index(virus_dir); });
+        if (!ok) return 1;
+        std::cout << "Signature index saved for " << virus_dir << " in " << t << "secs\n";
+        return 0;
+    }
+
+    // --binary：文档检索结果写成二进制格式 result_document.bin（差分 + varint，见 result_writer.hpp）
+    std::vector<std::string> args;
+    ResultFormat format = ResultFormat::Text;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--binary") {
+            format = ResultFormat::Binary;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() < 2) {
+        std::cerr << "Please run the project by: ./myapp <input_data_dir> <output_dir> [num_threads] [--binary]\n";
+        std::cerr << "                       or: ./myapp --calibrate [config_path]\n";
+        std::cerr << "                       or: ./myapp --build-index <input_data_dir> [num_threads]\n";
         return 1;
     }
 
-    std::string input_root = argv[1];
-    std::string output_root = argv[2];
-    int num_threads = (argc >= 4) ? std::stoi(argv[3]) : 10;
+    std::string input_root = args[0];
+    std::string output_root = args[1];
+    int num_threads = (args.size() >= 3) ? std::stoi(args[2]) : 10;
+
+    // 全局线程池按 num_threads 创建，各并行匹配入口复用同一组工作线程
+    configure_thread_pool(num_threads);
+
+    // 有校准配置时按其选择算法与并发度，否则使用内置默认阈值
+    load_tuning_config(default_tuning_path());
 
     // 创建输出目录
     std::filesystem::create_directories(output_root);
 
     std::cout << "Running document search...\n";
-    double t =
-        time_it(run_doc_search, input_root + "/document_retrieval", output_root + "/result_document.txt", num_threads);
+    const std::string doc_output =
+        output_root + (format == ResultFormat::Binary ? "/result_document.bin" : "/result_document.txt");
+    double t = time_it([&]() { run_doc_search(input_root + "/document_retrieval", doc_output, num_threads, format); });
     std::cout << "Document search done.\n";
     std::cout << "Doc search use time:" << t << "secs\n";
 
     std::cout << "Running virus scan...\n";
-    t = time_it(run_virus_search, input_root + "/software_antivirus", output_root + "/result_software.txt",
-                num_threads);
+    t = time_it([&]() {
+        run_virus_search(input_root + "/software_antivirus", output_root + "/result_software.txt", num_threads);
+    });
     std::cout << "Doc search use time:" << t << "secs\n";
     std::cout << "Virus scan done.\n";
 
@@ -0,0 +1,390 @@
+#include "batch_reader.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#ifdef __unix__
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(STATX_SIZE)
+#define PSM_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace {
+// 按文件大小准备缓冲区：已有容量够用就沿用，否则从池中换一块
+void reserve_buffer(BatchFile& file, size_t size) {
+    if (file.data.capacity() < size) file.data = BufferPool::instance().acquire(size);
+    file.size = size;
+}
+
+#ifdef __unix__
+// 从 offset 起读满 size 字节（或到文件尾），返回读到的字节数，出错返回 -1
+ssize_t read_fully(int fd, char* data, size_t size, size_t offset, std::atomic<size_t>& syscalls) {
+    size_t done = 0;
+    while (done < size) {
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+        ssize_t got = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) return -1;
+        if (got == 0) break;
+        done += static_cast<size_t>(got);
+    }
+    return static_cast<ssize_t>(done);
+}
+#endif
+}  // namespace
+
+#ifdef PSM_HAVE_IO_URING
+// 直接使用 io_uring 系统调用（不依赖 liburing）：映射提交队列、完成队列与 SQE 数组
+struct BatchReader::Ring {
+    int fd{-1};
+    void* sq_ptr{nullptr};
+    size_t sq_size{0};
+    void* cq_ptr{nullptr};
+    size_t cq_size{0};
+    io_uring_sqe* sqes{nullptr};
+    size_t sqes_size{0};
+
+    unsigned* sq_tail{nullptr};
+    unsigned* sq_mask{nullptr};
+    unsigned* sq_array{nullptr};
+    unsigned sq_entries{0};
+    unsigned* cq_head{nullptr};
+    unsigned* cq_tail{nullptr};
+    unsigned* cq_mask{nullptr};
+    io_uring_cqe* cqes{nullptr};
+    unsigned queued{0};  // 已填写、尚未提交的 SQE 数
+
+    ~Ring() {
+        if (sqes != nullptr) ::munmap(sqes, sqes_size);
+        if (cq_ptr != nullptr && cq_ptr != sq_ptr) ::munmap(cq_ptr, cq_size);
+        if (sq_ptr != nullptr) ::munmap(sq_ptr, sq_size);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool setup(unsigned entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false;
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) sq_size = cq_size = std::max(sq_size, cq_size);
+
+        sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            sq_ptr = nullptr;
+            return false;
+        }
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr =
+                ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                cq_ptr = nullptr;
+                return false;
+            }
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes_ptr =
+            ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes_ptr == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(sqes_ptr);
+
+        char* sq = static_cast<char*>(sq_ptr);
+        char* cq = static_cast<char*>(cq_ptr);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // 取下一个空闲 SQE 并清零；调用方保证一轮的 SQE 数不超过 sq_entries
+    io_uring_sqe* next_sqe(std::uint8_t opcode, std::uint64_t user_data) {
+        unsigned tail = *sq_tail + queued;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->user_data = user_data;
+        sq_array[index] = index;
+        ++queued;
+        return sqe;
+    }
+
+    // 提交本轮全部 SQE 并等待 expect 个完成事件，逐个交给 fn(user_data, res)。
+    // io_uring_enter 被信号打断，或返回 EBUSY / EAGAIN（完成队列已满、内核暂缺资源）时先收割完成事件再重新提交；
+    // 其他错误返回 false，返回前等已提交的请求全部完成，调用方随后可以安全地改用缓冲区、关闭文件
+    template <typename Fn> bool submit_and_reap(unsigned expect, std::atomic<size_t>& syscalls, Fn fn) {
+        __atomic_store_n(sq_tail, *sq_tail + queued, __ATOMIC_RELEASE);
+        const unsigned total = queued;
+        unsigned to_submit = queued;
+        queued = 0;
+
+        unsigned reaped = 0;
+        auto reap = [&]() {
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            unsigned got = 0;
+            for (; head != tail; ++head, ++got) {
+                const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                fn(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+            reaped += got;
+            return got;
+        };
+        auto enter = [&](unsigned submit, unsigned wait) {
+            syscalls.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<int>(
+                ::syscall(__NR_io_uring_enter, fd, submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0));
+        };
+        auto in_flight = [&]() { return total - to_submit - reaped; };
+
+        int stalls = 0;  // 连续没有进展的重试次数
+        bool failed = false;
+        while (reaped < expect) {
+            int ret = enter(to_submit, expect - reaped);
+            if (ret >= 0) {
+                to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(ret));
+                reap();
+                stalls = 0;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            if (errno != EBUSY && errno != EAGAIN) {
+                failed = true;
+                break;
+            }
+            if (reap() > 0) {
+                stalls = 0;
+            } else if (in_flight() > 0) {
+                // 完成队列满或资源不足：先等一个已提交的请求完成，腾出位置后再提交
+                if (enter(0, 1) >= 0) reap();
+            } else if (++stalls > 16) {
+                failed = true;
+                break;
+            } else {
+                ::sched_yield();
+            }
+        }
+        if (!failed) return true;
+
+        // 已提交的请求仍可能写缓冲区、占用文件描述符，全部收割后才交还调用方；未提交的 SQE 随环一起丢弃
+        while (in_flight() > 0) {
+            if (enter(0, in_flight()) < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) break;
+            reap();
+        }
+        return false;
+    }
+};
+
+bool io_uring_compiled() { return true; }
+#else
+struct BatchReader::Ring {};
+
+bool io_uring_compiled() { return false; }
+#endif
+
+BatchReader::BatchReader(size_t batch_size, bool allow_io_uring) : batch_size_(std::max<size_t>(batch_size, 1)) {
+#ifdef PSM_HAVE_IO_URING
+    if (allow_io_uring) {
+        // 每个文件一轮最多两个 SQE（openat + statx，或 read + close）
+        auto ring = std::make_unique<Ring>();
+        if (ring->setup(static_cast<unsigned>(2 * batch_size_))) ring_ = std::move(ring);
+    }
+#else
+    (void)allow_io_uring;
+#endif
+}
+
+BatchReader::~BatchReader() = default;
+
+void BatchReader::read(const std::string* paths, size_t count, BatchFile* out) {
+    for (size_t first = 0; first < count; first += batch_size_) {
+        size_t n = std::min(batch_size_, count - first);
+        if (ring_) {
+            read_batch_ring(paths + first, n, out + first);
+        } else {
+            read_batch_fallback(paths + first, n, out + first);
+        }
+    }
+}
+
+void BatchReader::read_batch_ring(const std::string* paths, size_t count, BatchFile* out) {
+#ifdef PSM_HAVE_IO_URING
+    Ring& ring = *ring_;
+    std::vector<int> fds(count, -1);
+    std::vector<struct statx> stats(count);
+    std::vector<int> stat_ok(count, 0);
+    bool unsupported = false;
+
+    // 第一轮：openat 与 statx（都按路径，互不依赖）
+    for (size_t k = 0; k < count; ++k) {
+        io_uring_sqe* open = ring.next_sqe(IORING_OP_OPENAT, 2 * k);
+        open->fd = AT_FDCWD;
+        open->addr = reinterpret_cast<std::uint64_t>(paths[k].c_str());
+        open->open_flags = O_RDONLY | O_CLOEXEC;
+
+        io_uring_sqe* stat = ring.next_sqe(IORING_OP_STATX, 2 * k + 1);
+        stat->fd = AT_FDCWD;
+        stat->addr = reinterpret_cast<std::uint64_t>(paths[k].c_str());
+        stat->len = STATX_SIZE;
+        stat->off = reinterpret_cast<std::uint64_t>(&stats[k]);
+    }
+    bool ok = ring.submit_and_reap(static_cast<unsigned>(2 * count), syscalls_, [&](std::uint64_t id, int res) {
+        size_t k = id / 2;
+        if (res == -EINVAL || res == -EOPNOTSUPP) unsupported = true;
+        if (id % 2 == 0) {
+            fds[k] = res >= 0 ? res : -1;
+        } else {
+            stat_ok[k] = res == 0;
+        }
+    });
+
+    auto close_all = [&]() {
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            syscalls_.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+        }
+    };
+    // 内核不支持这些操作码（或提交失败）：之后都改用同步读取
+    if (!ok || unsupported) {
+        close_all();
+        ring_.reset();
+        read_batch_fallback(paths, count, out);
+        return;
+    }
+
+    // 第二轮：read 与其后链接的 close；短读或 read 失败会断开链接（close 返回 -ECANCELED），由下面同步补读后关闭
+    unsigned expect = 0;
+    std::vector<int> closed(count, 0);
+    std::vector<std::int64_t> got(count, -1);
+    for (size_t k = 0; k < count; ++k) {
+        out[k].ok = false;
+        out[k].size = 0;
+        if (fds[k] < 0 || !stat_ok[k]) continue;  // statx 失败的文件下面同步 fstat
+        const std::uint64_t size = stats[k].stx_size;
+        reserve_buffer(out[k], static_cast<size_t>(size));
+        if (size > 0 && size <= UINT32_MAX) {
+            io_uring_sqe* read = ring.next_sqe(IORING_OP_READ, 2 * k);
+            read->fd = fds[k];
+            read->addr = reinterpret_cast<std::uint64_t>(out[k].data.data());
+            read->len = static_cast<std::uint32_t>(size);
+            read->off = 0;
+            read->flags = IOSQE_IO_LINK;
+            ++expect;
+        } else if (size > UINT32_MAX) {
+            continue;  // 超出单次 read 长度，下面同步读取后关闭
+        }
+        io_uring_sqe* close = ring.next_sqe(IORING_OP_CLOSE, 2 * k + 1);
+        close->fd = fds[k];
+        ++expect;
+    }
+    ok = ring.submit_and_reap(expect, syscalls_, [&](std::uint64_t id, int res) {
+        size_t k = id / 2;
+        if (id % 2 == 0) {
+            got[k] = res;
+        } else {
+            closed[k] = res != -ECANCELED;
+        }
+    });
+
+    for (size_t k = 0; k < count; ++k) {
+        if (fds[k] < 0) {
+            std::cout << "Fail to open file: " << paths[k] << std::endl;
+            continue;
+        }
+        bool read_ok = true;
+        if (!stat_ok[k]) {
+            struct stat st{};
+            syscalls_.fetch_add(1, std::memory_order_relaxed);
+            read_ok = ::fstat(fds[k], &st) == 0;
+            if (read_ok) reserve_buffer(out[k], static_cast<size_t>(st.st_size));
+        }
+        // read 失败、短读、未能提交或超出单次 read 长度：同步读完剩余部分。
+        // 部分提交可能拆开 read 与 close 的链接，close 已先执行时按路径重新打开
+        size_t done = got[k] > 0 ? static_cast<size_t>(got[k]) : 0;
+        if (read_ok && done < out[k].size) {
+            int fd = fds[k];
+            if (closed[k]) {
+                syscalls_.fetch_add(1, std::memory_order_relaxed);
+                fd = ::open(paths[k].c_str(), O_RDONLY | O_CLOEXEC);
+                closed[k] = 0;
+            }
+            ssize_t rest = fd < 0 ? -1 : read_fully(fd, out[k].data.data() + done, out[k].size - done, done, syscalls_);
+            read_ok = rest >= 0;
+            if (read_ok) done += static_cast<size_t>(rest);
+            fds[k] = fd;
+        }
+        out[k].ok = read_ok;
+        out[k].size = read_ok ? done : 0;
+        if (!closed[k] && fds[k] >= 0) {
+            syscalls_.fetch_add(1, std::memory_order_relaxed);
+            ::close(fds[k]);
+        }
+        if (!read_ok) std::cout << "Fail to open file: " << paths[k] << std::endl;
+    }
+    if (!ok) ring_.reset();
+#else
+    read_batch_fallback(paths, count, out);
+#endif
+}
+
+// 回退：在调用线程上逐个 open、fstat、read、close。调用方是 FilePrefetcher 的读取线程，
+// 不能向线程池提交任务或等待线程池（消费者可能正占着线程池等待本线程）
+void BatchReader::read_batch_fallback(const std::string* paths, size_t count, BatchFile* out) {
+    for (size_t k = 0; k < count; ++k) {
+        BatchFile& file = out[k];
+        file.ok = false;
+        file.size = 0;
+#ifdef __unix__
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        int fd = ::open(paths[k].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cout << "Fail to open file: " << paths[k] << std::endl;
+            continue;
+        }
+        struct stat st{};
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        if (::fstat(fd, &st) == 0) {
+            reserve_buffer(file, static_cast<size_t>(st.st_size));
+            ssize_t got = read_fully(fd, file.data.data(), file.size, 0, syscalls_);
+            if (got >= 0) {
+                file.size = static_cast<size_t>(got);
+                file.ok = true;
+            } else {
+                file.size = 0;
+            }
+        }
+        syscalls_.fetch_add(1, std::memory_order_relaxed);
+        ::close(fd);
+        if (!file.ok) std::cout << "Fail to open file: " << paths[k] << std::endl;
+#else
+        std::vector<char> data = read_binary_file(paths[k]);
+        reserve_buffer(file, data.size());
+        std::copy(data.begin(), data.end(), file.data.data());
+        file.ok = true;
+#endif
+    }
+}
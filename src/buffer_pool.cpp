@@ -0,0 +1,104 @@
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this == &other) return *this;
+    reset();
+    owner_ = other.owner_;
+    data_ = other.data_;
+    capacity_ = other.capacity_;
+    other.owner_ = nullptr;
+    other.data_ = nullptr;
+    other.capacity_ = 0;
+    return *this;
+}
+
+void PooledBuffer::reset() {
+    if (owner_ != nullptr) owner_->release(data_, capacity_);
+    owner_ = nullptr;
+    data_ = nullptr;
+    capacity_ = 0;
+}
+
+BufferPool::BufferPool(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes), free_(class_index(kMaxClassBytes) + 1) {}
+
+BufferPool::~BufferPool() { trim(); }
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+size_t BufferPool::class_index(size_t size) {
+    size_t index = 0;
+    for (size_t bytes = kMinClassBytes; bytes < size; bytes <<= 1) ++index;
+    return index;
+}
+
+PooledBuffer BufferPool::acquire(size_t size) {
+    PooledBuffer buffer;
+    if (size == 0) return buffer;
+
+    const bool pooled = size <= kMaxClassBytes;
+    const size_t index = pooled ? class_index(size) : 0;
+    buffer.capacity_ = pooled ? (kMinClassBytes << index) : size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.peak_live = std::max(stats_.peak_live, ++stats_.live);
+        if (pooled && !free_[index].empty()) {
+            buffer.data_ = free_[index].back();
+            free_[index].pop_back();
+            --stats_.cached;
+            stats_.cached_bytes -= buffer.capacity_;
+            ++stats_.reuses;
+            buffer.owner_ = this;
+            return buffer;
+        }
+        ++stats_.allocations;
+    }
+    // new char[] 不做值初始化，省去清零与随之而来的逐页缺页
+    buffer.data_ = new char[buffer.capacity_];
+    buffer.owner_ = this;
+    return buffer;
+}
+
+void BufferPool::release(char* data, size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --stats_.live;
+        if (capacity <= kMaxClassBytes && stats_.cached_bytes + capacity <= max_cached_bytes_) {
+            free_[class_index(capacity)].push_back(data);
+            ++stats_.cached;
+            stats_.cached_bytes += capacity;
+            return;
+        }
+    }
+    delete[] data;
+}
+
+BufferPoolStats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void BufferPool::reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.allocations = 0;
+    stats_.reuses = 0;
+    stats_.peak_live = stats_.live;
+}
+
+void BufferPool::trim() {
+    std::vector<std::vector<char*>> freed(free_.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freed.swap(free_);
+        stats_.cached = 0;
+        stats_.cached_bytes = 0;
+    }
+    for (std::vector<char*>& list : freed) {
+        for (char* data : list) delete[] data;
+    }
+}
@@ -0,0 +1,176 @@
+#include "dir_walker.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+#ifdef __unix__
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+std::string join_path(const std::string& dir, const std::string& name) {
+    if (!dir.empty() && dir.back() == '/') return dir + name;
+    return dir + "/" + name;
+}
+
+#ifdef __unix__
+bool stat_is_regular(const std::string& path) {
+    struct stat st{};
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+#endif
+
+// 列出一个目录的直接子项：普通文件（含指向文件的符号链接）与子目录（不含符号链接），index 为目录项序号
+template <typename OnFile, typename OnDir> void list_directory(const std::string& dir, OnFile on_file, OnDir on_dir) {
+#ifdef __unix__
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) return;
+    std::uint32_t index = 0;
+    while (dirent* e = readdir(handle)) {
+        const std::string name = e->d_name;
+        if (name == "." || name == "..") continue;
+        std::string child = join_path(dir, name);
+
+        switch (e->d_type) {
+        case DT_REG:
+            on_file(std::move(child), index);
+            break;
+        case DT_DIR:
+            on_dir(std::move(child), index);
+            break;
+        case DT_LNK:
+            if (stat_is_regular(child)) on_file(std::move(child), index);
+            break;
+        case DT_UNKNOWN: {
+            // 部分文件系统不填 d_type，只对这类目录项 lstat
+            struct stat st{};
+            if (lstat(child.c_str(), &st) != 0) break;
+            if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat_is_regular(child))) {
+                on_file(std::move(child), index);
+            } else if (S_ISDIR(st.st_mode)) {
+                on_dir(std::move(child), index);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        ++index;
+    }
+    closedir(handle);
+#else
+    std::error_code ec;
+    std::uint32_t index = 0;
+    for (auto it = std::filesystem::directory_iterator(dir, ec); !ec && it != std::filesystem::directory_iterator();
+         it.increment(ec), ++index) {
+        std::error_code type_ec;
+        if (it->is_symlink(type_ec)) {
+            if (it->is_regular_file(type_ec)) on_file(it->path().string(), index);
+        } else if (it->is_directory(type_ec)) {
+            on_dir(it->path().string(), index);
+        } else if (it->is_regular_file(type_ec)) {
+            on_file(it->path().string(), index);
+        }
+    }
+#endif
+}
+}  // namespace
+
+bool walk_order_less(const WalkEntry& a, const WalkEntry& b) { return a.order < b.order; }
+
+DirectoryWalker::DirectoryWalker(const std::string& root, size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+    std::vector<Directory> dirs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        schedule(Directory{root, {}}, dirs);
+    }
+    launch(dirs);
+}
+
+DirectoryWalker::~DirectoryWalker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        deferred_.clear();
+    }
+    group_.wait();
+}
+
+void DirectoryWalker::schedule(Directory dir, std::vector<Directory>& launch) {
+    if (stop_) return;
+    if (files_.size() >= capacity_) {
+        deferred_.push_back(std::move(dir));
+        return;
+    }
+    ++active_;
+    launch.push_back(std::move(dir));
+}
+
+void DirectoryWalker::launch(std::vector<Directory>& dirs) {
+    if (dirs.empty()) return;
+    for (Directory& dir : dirs) {
+        group_.run([this, dir = std::move(dir)]() { visit(dir); });
+    }
+    dirs.clear();
+    // 阻塞在 next 中的消费者可以帮忙执行新派发的目录任务（线程池没有空闲线程时只能靠它们）
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    cv_.notify_all();
+}
+
+void DirectoryWalker::visit(const Directory& dir) {
+    std::vector<WalkEntry> files;
+    std::vector<Directory> subdirs;
+    auto child_order = [&](std::uint32_t index) {
+        std::vector<std::uint32_t> order = dir.order;
+        order.push_back(index);
+        return order;
+    };
+    list_directory(
+        dir.path, [&](std::string path, std::uint32_t index) { files.push_back({std::move(path), child_order(index)}); },
+        [&](std::string path, std::uint32_t index) { subdirs.push_back({std::move(path), child_order(index)}); });
+
+    std::vector<Directory> launch_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (WalkEntry& file : files) files_.push_back(std::move(file));
+        for (Directory& sub : subdirs) schedule(std::move(sub), launch_now);
+        --active_;
+    }
+    cv_.notify_all();
+    launch(launch_now);
+}
+
+bool DirectoryWalker::next(WalkEntry& entry) {
+    for (;;) {
+        std::vector<Directory> resumed;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!files_.empty()) {
+                entry = std::move(files_.front());
+                files_.pop_front();
+                // 队列回落到容量以下，恢复暂缓的目录
+                if (files_.size() < capacity_ && !deferred_.empty()) {
+                    std::vector<Directory> deferred;
+                    deferred.swap(deferred_);
+                    for (Directory& dir : deferred) schedule(std::move(dir), resumed);
+                }
+            } else if (active_ == 0 && deferred_.empty()) {
+                return false;
+            } else {
+                lock.unlock();
+                // 文件尚未到达：帮忙执行本遍历的目录任务，不接手线程池中其他组的任务
+                if (group_.try_run_one()) continue;
+                lock.lock();
+                cv_.wait(lock, [this]() {
+                    return !files_.empty() || (active_ == 0 && deferred_.empty()) || group_.has_pending();
+                });
+                continue;
+            }
+        }
+        launch(resumed);
+        return true;
+    }
+}
@@ -0,0 +1,224 @@
+#include "doc_index.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+using StrView = std::string_view;
+
+namespace {
+// 索引文件（见 index_file.hpp）中的 section：源文档状态、规范化文本、后缀数组
+constexpr std::uint32_t kDocIndexKind = index_tag("DOCX");
+constexpr std::uint32_t kTagSource = index_tag("SRCS");
+constexpr std::uint32_t kTagText = index_tag("TEXT");
+constexpr std::uint32_t kTagSuffixArray = index_tag("SUFA");
+
+struct SortEntry {
+    std::uint64_t key;  // 第一轮为前缀编码，之后为 rank[i+k] + 1（越界为 0）
+    std::uint32_t idx;
+};
+
+bool entry_less(const SortEntry& a, const SortEntry& b) { return a.key < b.key; }
+
+// 分段并行排序后两两并行归并
+void parallel_sort(std::vector<SortEntry>& entries, int num_threads) {
+    const size_t n = entries.size();
+    int parts = static_cast<int>(std::min<size_t>(std::max(num_threads, 1), std::max<size_t>(1, n >> 16)));
+
+    std::vector<size_t> bounds(parts + 1);
+    for (int p = 0; p <= parts; ++p) bounds[p] = n * p / parts;
+
+    parallel_for(parts, [&](int p) {
+        std::sort(entries.begin() + bounds[p], entries.begin() + bounds[p + 1], entry_less);
+    });
+
+    for (int width = 1; width < parts; width *= 2) {
+        int merges = (parts + 2 * width - 1) / (2 * width);
+        parallel_for(merges, [&](int k) {
+            int lo = 2 * width * k;
+            int mid = std::min(lo + width, parts);
+            int hi = std::min(lo + 2 * width, parts);
+            if (mid < hi) {
+                std::inplace_merge(entries.begin() + bounds[lo], entries.begin() + bounds[mid],
+                                   entries.begin() + bounds[hi], entry_less);
+            }
+        });
+    }
+}
+}  // namespace
+
+SuffixArrayIndex SuffixArrayIndex::build(StrView text, int num_threads) {
+    SuffixArrayIndex index;
+    index.owned_text_.assign(text.begin(), text.end());
+    index.text_ = StrView(index.owned_text_.data(), index.owned_text_.size());
+
+    const size_t n = text.size();
+    if (n == 0) return index;
+    if (n >= 0xffffffffULL) {
+        std::cerr << "Document too large for 32-bit suffix array index" << std::endl;
+        index = SuffixArrayIndex();
+        return index;
+    }
+
+    const int parts = static_cast<int>(std::min<size_t>(std::max(num_threads, 1), std::max<size_t>(1, n >> 16)));
+    std::vector<size_t> bounds(parts + 1);
+    for (int p = 0; p <= parts; ++p) bounds[p] = n * p / parts;
+
+    // 第一轮：按前 7 字节排序。每字节记为 byte+1（越界为 0）占 9 位，共 63 位，保证短后缀排在前面
+    std::vector<SortEntry> entries(n);
+    parallel_for(parts, [&](int p) {
+        for (size_t i = bounds[p]; i < bounds[p + 1]; ++i) {
+            std::uint64_t key = 0;
+            for (size_t d = 0; d < 7; ++d) key = key << 9 | (i + d < n ? (unsigned char)text[i + d] + 1u : 0u);
+            entries[i] = SortEntry{key, static_cast<std::uint32_t>(i)};
+        }
+    });
+    parallel_sort(entries, num_threads);
+
+    // 名次取所在组（前缀相同的连续区间）在排序结果中的起点；仍有并列的组留待下一轮细分
+    std::vector<std::uint32_t> rank(n);
+    std::vector<std::pair<size_t, size_t>> groups;
+    for (size_t j = 0, g = 0; j < n; ++j) {
+        if (j > 0 && entries[j].key != entries[j - 1].key) {
+            if (j - g > 1) groups.emplace_back(g, j);
+            g = j;
+        }
+        rank[entries[j].idx] = static_cast<std::uint32_t>(g);
+        if (j + 1 == n && n - g > 1) groups.emplace_back(g, n);
+    }
+
+    // 前缀倍增：组内按 rank[i+k] 排序即按前 2k 字节排序。只处理未分开的组，已唯一的后缀不再参与
+    for (size_t k = 7; !groups.empty() && k < n; k *= 2) {
+        // 先读旧名次算出全部 key，再排序并改写名次，保证同一轮内读到的都是上一轮的名次
+        parallel_for_dynamic(groups.size(), parts, [&](size_t id) {
+            for (size_t j = groups[id].first; j < groups[id].second; ++j) {
+                size_t i = entries[j].idx;
+                entries[j].key = (i + k < n) ? std::uint64_t(rank[i + k]) + 1 : 0;
+            }
+        });
+        parallel_for_dynamic(groups.size(), parts, [&](size_t id) {
+            auto first = entries.begin() + groups[id].first;
+            auto last = entries.begin() + groups[id].second;
+            std::sort(first, last, entry_less);
+            size_t g = groups[id].first;
+            for (size_t j = groups[id].first; j < groups[id].second; ++j) {
+                if (j > groups[id].first && entries[j].key != entries[j - 1].key) g = j;
+                rank[entries[j].idx] = static_cast<std::uint32_t>(g);
+            }
+        });
+
+        std::vector<std::pair<size_t, size_t>> next_groups;
+        for (const auto& group : groups) {
+            size_t g = group.first;
+            for (size_t j = group.first + 1; j <= group.second; ++j) {
+                if (j == group.second || entries[j].key != entries[j - 1].key) {
+                    if (j - g > 1) next_groups.emplace_back(g, j);
+                    g = j;
+                }
+            }
+        }
+        groups.swap(next_groups);
+    }
+
+    index.owned_sa_.resize(n);
+    parallel_for(parts, [&](int p) {
+        for (size_t j = bounds[p]; j < bounds[p + 1]; ++j) index.owned_sa_[j] = entries[j].idx;
+    });
+    index.sa_ = index.owned_sa_.data();
+    return index;
+}
+
+bool SuffixArrayIndex::save(const std::string& path, std::uint64_t source_size, std::int64_t source_mtime) const {
+    const std::uint64_t source[2] = {source_size, static_cast<std::uint64_t>(source_mtime)};
+
+    IndexWriter writer(kDocIndexKind);
+    writer.add(kTagSource, source, sizeof(source), sizeof(std::uint64_t));
+    writer.add(kTagText, text_.data(), text_.size());
+    writer.add(kTagSuffixArray, sa_, text_.size() * sizeof(std::uint32_t), sizeof(std::uint32_t));
+    return writer.write(path);
+}
+
+// 只检查 header 与 section 表，不遍历文本与后缀数组：多 GB 的索引也只需一次 mmap，页按查询需要换入
+bool SuffixArrayIndex::load(const std::string& path, std::uint64_t source_size, std::int64_t source_mtime) {
+    IndexFile file;
+    if (!file.open(path, kDocIndexKind)) return false;
+
+    ConstSpan<std::uint64_t> source;
+    std::string_view text;
+    ConstSpan<std::uint32_t> sa;
+    if (!file.array(kTagSource, source) || source.size() != 2 || !file.bytes(kTagText, text) ||
+        !file.array(kTagSuffixArray, sa) || text.empty() || sa.size() != text.size()) {
+        return false;
+    }
+    if (source[0] != source_size || source[1] != static_cast<std::uint64_t>(source_mtime)) return false;
+
+    *this = SuffixArrayIndex();
+    file_ = std::move(file);
+    text_ = text;
+    sa_ = sa.data();
+    return true;
+}
+
+std::pair<size_t, size_t> SuffixArrayIndex::equal_range(StrView pattern) const {
+    const size_t n = text_.size();
+    const size_t m = pattern.size();
+    auto prefix = [&](size_t j) { return text_.substr(sa_[j], m); };
+
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (prefix(mid) < pattern) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    size_t first = lo;
+    hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (prefix(mid) == pattern) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return {first, lo};
+}
+
+std::vector<MatchPos> SuffixArrayIndex::find(StrView pattern) const {
+    std::vector<MatchPos> positions;
+    if (sa_ == nullptr || pattern.empty() || pattern.size() > text_.size()) return positions;
+
+    auto range = equal_range(pattern);
+    positions.reserve(range.second - range.first);
+    for (size_t j = range.first; j < range.second; ++j) positions.push_back(static_cast<MatchPos>(sa_[j]));
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+size_t SuffixArrayIndex::count(StrView pattern) const {
+    if (sa_ == nullptr || pattern.empty() || pattern.size() > text_.size()) return 0;
+    auto range = equal_range(pattern);
+    return range.second - range.first;
+}
+
+std::string doc_index_path(const std::string& doc_path) { return doc_path + ".sa"; }
+
+bool build_doc_index(const std::string& doc_path, int num_threads) {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    if (!file_stat(doc_path, size, mtime)) {
+        std::cerr << "Fail to stat file: " << doc_path << std::endl;
+        return false;
+    }
+
+    // 与 run_doc_search 相同的规范化：去掉 '\r'
+    FileView doc_view = read_file_view(doc_path);
+    NormalizedText normalized = strip_carriage_returns(doc_view.view, num_threads);
+    std::string_view text = normalized.view;
+
+    SuffixArrayIndex index = SuffixArrayIndex::build(text, num_threads);
+    if (index.empty()) return false;
+    return index.save(doc_index_path(doc_path), size, mtime);
+}
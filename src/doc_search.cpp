@@ -1,41 +1,55 @@
 #include "doc_search.hpp"
+#include "doc_index.hpp"
 #include "matcher.hpp"
+#include "tuning.hpp"
 #include "utils.hpp"
 #include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
-void run_doc_search(const std::string& input_dir, const std::string& output_path, int num_threads) {
-    // 1. 读取 document.txt
+void run_doc_search(const std::string& input_dir, const std::string& output_path, int num_threads,
+                    ResultFormat format) {
     const std::string doc_path = input_dir + "/document.txt";
     const std::string target_path = input_dir + "/target.txt";
-    FileView doc_view = read_file_view(doc_path);
-    std::string text(doc_view.view);
-    text.erase(std::remove(text.begin(), text.end(), '\r'), text.end());
-    //  2. 读取 target.txt（每行一个 pattern）
+
+    // 1. 读取 target.txt（每行一个 pattern）
     std::vector<std::string> patterns;
     std::ifstream fin(target_path);
     std::string line;
     while (std::getline(fin, line)) {
         if (!line.empty()) patterns.push_back(line);
     }
-    // 3. 对每个 pattern 调用 match_parallel
-
-    std::vector<std::vector<int>> positions;
 
-    for (const std::string& pattern : patterns) {
-        std::vector<int> position = match_parallel(text, pattern, num_threads);
-        positions.push_back(position);
-    }
+    // 2. 存在与 document.txt 匹配的后缀数组索引（./myapp --build-index 生成）时直接查询，不再读取和扫描文档
+    std::vector<std::vector<MatchPos>> positions;
+    std::uint64_t doc_size = 0;
+    std::int64_t doc_mtime = 0;
+    const std::string index_path = doc_index_path(doc_path);
+    SuffixArrayIndex index;
+    if (file_stat(doc_path, doc_size, doc_mtime) && std::filesystem::exists(index_path) &&
+        index.load(index_path, doc_size, doc_mtime)) {
+        for (const std::string& pattern : patterns) positions.push_back(index.find(pattern));
+    } else {
+        // 3. 读取 document.txt
+        FileView doc_view = read_file_view(doc_path);
+        NormalizedText normalized =
+            strip_carriage_returns(doc_view.view, choose_threads(doc_view.view.size(), num_threads));
+        std::string_view text = normalized.view;
 
-    // 4. 写入 output 文件
-    std::ofstream fout(output_path);
-
-    for (const std::vector<int>& p : positions) {
-        fout << p.size();
-        for (const int& pos : p) {
-            fout << " " << pos;
+        // 4. pattern 较多时编译进同一个 Aho-Corasick 自动机，对文档只做一次并行扫描；
+        //    较少时各自编译为自动选择的单模式内核，由 match_batch 按文本大小与模式串数决定并行方式
+        if (prefer_multi_pattern(patterns.size())) {
+            AhoCorasick automaton(patterns);
+            positions = automaton.match_parallel(text, choose_threads(text.size(), num_threads));
+        } else {
+            std::vector<CompiledPattern> compiled;
+            compiled.reserve(patterns.size());
+            for (const std::string& pattern : patterns) compiled.emplace_back(pattern, MatchAlgo::Auto);
+            positions = match_batch(text, compiled, BatchOptions{num_threads, BatchStrategy::Auto});
         }
-        fout << std::endl;
     }
+
+    // 5. 写入 output 文件：并行格式化后大块写出（或写成二进制格式）
+    write_position_lists(output_path, positions, num_threads, format);
 }
@@ -0,0 +1,188 @@
+#include "file_prefetcher.hpp"
+#include "batch_reader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+PrefetchedFile& PrefetchedFile::operator=(PrefetchedFile&& other) noexcept {
+    if (this == &other) return *this;
+    reset();
+    owner_ = other.owner_;
+    index_ = other.index_;
+    bytes_ = other.bytes_;
+    file_ = std::move(other.file_);
+    other.owner_ = nullptr;
+    other.bytes_ = 0;
+    return *this;
+}
+
+void PrefetchedFile::reset() {
+    // 先释放映射 / 缓冲区，再归还额度
+    file_ = FileView();
+    if (owner_ != nullptr) owner_->release(bytes_);
+    owner_ = nullptr;
+    bytes_ = 0;
+}
+
+FilePrefetcher::FilePrefetcher(std::vector<std::string> paths) : FilePrefetcher(std::move(paths), Options()) {}
+
+FilePrefetcher::FilePrefetcher(std::vector<std::string> paths, Options options)
+    : FilePrefetcher(std::move(paths), std::vector<size_t>(), options) {}
+
+FilePrefetcher::FilePrefetcher(std::vector<std::string> paths, std::vector<size_t> sizes)
+    : FilePrefetcher(std::move(paths), std::move(sizes), Options()) {}
+
+FilePrefetcher::FilePrefetcher(std::vector<std::string> paths, std::vector<size_t> sizes, Options options)
+    : paths_(std::move(paths)), sizes_(std::move(sizes)), options_(options) {
+    if (sizes_.size() != paths_.size()) sizes_.clear();
+    const int readers = std::max(options_.readers, 1);
+    readers_running_ = static_cast<size_t>(readers);
+    for (int r = 0; r < readers; ++r) readers_.emplace_back([this]() { reader_loop(); });
+}
+
+FilePrefetcher::~FilePrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    space_cv_.notify_all();
+    for (std::thread& reader : readers_) reader.join();
+}
+
+void FilePrefetcher::reader_loop() {
+    // 每个读取线程各有一个批量读取器（io_uring 实例不在线程间共享）
+    std::unique_ptr<BatchReader> batch_reader;
+    if (options_.batch_files > 1) batch_reader = std::make_unique<BatchReader>(options_.batch_files);
+    const size_t claim = std::max<size_t>(options_.batch_files, 1);
+
+    std::vector<size_t> sizes;
+    std::vector<std::string> batch_paths;
+    std::vector<size_t> batch_indices;
+    std::vector<BatchFile> batch_out;
+    size_t first = 0;  // 当前领取的下标范围 [first, last)
+    size_t last = 0;
+
+    // 在途额度：大文件逐个计入，连续小文件按批计入（单份超过上限时在没有其他在途文件时照常读取）
+    auto reserve = [&](size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [&]() {
+            return stop_ || inflight_ == 0 || inflight_ + bytes <= options_.max_inflight_bytes;
+        });
+        if (stop_) return false;
+        inflight_ += bytes;
+        return true;
+    };
+    auto publish = [&](Ready* ready, size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t k = 0; k < count; ++k) ready_.push_back(std::move(ready[k]));
+        }
+        ready_cv_.notify_all();
+    };
+    auto flush_batch = [&]() {
+        if (batch_paths.empty()) return true;
+        size_t total = 0;
+        for (size_t index : batch_indices) total += sizes[index - first];
+        if (!reserve(total)) return false;
+        batch_out.resize(batch_paths.size());
+        batch_reader->read(batch_paths.data(), batch_paths.size(), batch_out.data());
+        std::vector<Ready> done;
+        for (size_t k = 0; k < batch_paths.size(); ++k) {
+            FileView file;
+            if (batch_out[k].ok) {
+                file.size = batch_out[k].size;
+                file.buffer = std::move(batch_out[k].data);
+                file.view = std::string_view(file.buffer.data(), file.size);
+            }
+            const size_t index = batch_indices[k];
+            done.push_back(Ready{index, sizes[index - first], std::move(file)});
+        }
+        publish(done.data(), done.size());
+        batch_paths.clear();
+        batch_indices.clear();
+        return true;
+    };
+
+    for (;;) {
+        std::vector<size_t> advise;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_ || next_path_ >= paths_.size()) break;
+            // 一次领取至多 batch_files 个连续文件，其中的小文件合并成一批读取
+            first = next_path_;
+            last = std::min(paths_.size(), first + claim);
+            next_path_ = last;
+            // 领到的文件马上就读，只对其后的 lookahead 个文件发出预读
+            advised_ = std::max(advised_, last);
+            const size_t upto = std::min(paths_.size(), last + options_.lookahead);
+            for (; advised_ < upto; ++advised_) advise.push_back(advised_);
+        }
+        for (size_t k : advise) prefetch_file(paths_[k]);
+
+        sizes.clear();
+        for (size_t index = first; index < last; ++index) {
+            if (!sizes_.empty()) {
+                sizes.push_back(sizes_[index]);
+                continue;
+            }
+            std::error_code ec;
+            const std::uintmax_t file_size = std::filesystem::file_size(paths_[index], ec);
+            sizes.push_back(ec ? 0 : static_cast<size_t>(file_size));
+        }
+        bool stopped = false;
+        for (size_t index = first; index < last; ++index) {
+            const size_t bytes = sizes[index - first];
+            if (batch_reader && bytes < options_.mmap_threshold) {
+                batch_paths.push_back(paths_[index]);
+                batch_indices.push_back(index);
+                continue;
+            }
+            if (!flush_batch() || !reserve(bytes)) {
+                stopped = true;
+                break;
+            }
+            Ready ready{index, bytes,
+                        read_file_view(paths_[index], options_.mmap_threshold, ReadHints{true, options_.populate})};
+            publish(&ready, 1);
+        }
+        if (stopped || !flush_batch()) break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --readers_running_;
+    }
+    ready_cv_.notify_all();
+}
+
+void FilePrefetcher::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inflight_ -= bytes;
+    }
+    space_cv_.notify_all();
+}
+
+size_t FilePrefetcher::inflight_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inflight_;
+}
+
+bool FilePrefetcher::next(PrefetchedFile& file) {
+    file.reset();
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 读取线程不使用线程池，这里直接等它读好下一个文件
+    ready_cv_.wait(lock, [this]() { return !ready_.empty() || readers_running_ == 0; });
+    if (ready_.empty()) return false;
+    Ready ready = std::move(ready_.front());
+    ready_.pop_front();
+    lock.unlock();
+
+    file.owner_ = this;
+    file.index_ = ready.index;
+    file.bytes_ = ready.bytes;
+    file.file_ = std::move(ready.file);
+    return true;
+}
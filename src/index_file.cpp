@@ -0,0 +1,150 @@
+#include "index_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+constexpr char kIndexMagic[8] = {'P', 'S', 'M', 'I', 'N', 'D', 'E', 'X'};
+constexpr size_t kSectionAlign = 64;
+static_assert(sizeof(IndexFileHeader) == 64, "index header layout");
+static_assert(sizeof(IndexSection) == 32, "index section layout");
+
+size_t align_up(size_t n) { return (n + kSectionAlign - 1) & ~(kSectionAlign - 1); }
+
+std::uint64_t header_checksum(IndexFileHeader header, const IndexSection* sections) {
+    header.checksum = 0;
+    std::uint64_t h = index_checksum(&header, sizeof(header));
+    return h ^ index_checksum(sections, header.section_count * sizeof(IndexSection)) * 31;
+}
+}  // namespace
+
+// 按 8 字节分组的乘法-异或散列，足以发现截断与损坏，速度接近内存带宽
+std::uint64_t index_checksum(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    for (; i < size; ++i) h = (h ^ p[i]) * 0x100000001b3ULL;
+    return h ^ (h >> 32);
+}
+
+void IndexWriter::add(std::uint32_t tag, const void* data, size_t size, std::uint32_t elem_size) {
+    sections_.push_back(Pending{tag, elem_size, data, size});
+}
+
+bool IndexWriter::write(const std::string& path) const {
+    IndexFileHeader header{};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexFormatVersion;
+    header.kind = kind_;
+    header.endian = kIndexEndianMark;
+    header.section_count = static_cast<std::uint32_t>(sections_.size());
+
+    std::vector<IndexSection> table(sections_.size());
+    size_t offset = align_up(sizeof(IndexFileHeader) + table.size() * sizeof(IndexSection));
+    for (size_t k = 0; k < sections_.size(); ++k) {
+        const Pending& s = sections_[k];
+        table[k] = IndexSection{s.tag, s.elem_size, offset, s.size, index_checksum(s.data, s.size)};
+        offset = align_up(offset + s.size);
+    }
+    header.file_size = offset;
+    header.checksum = header_checksum(header, table.data());
+
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream fout(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!fout.is_open()) {
+            std::cout << "Fail to open file: " << tmp_path << std::endl;
+            return false;
+        }
+        static const char zeros[kSectionAlign] = {};
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char*>(table.data()),
+                   static_cast<std::streamsize>(table.size() * sizeof(IndexSection)));
+        size_t written = sizeof(header) + table.size() * sizeof(IndexSection);
+        for (size_t k = 0; k < sections_.size(); ++k) {
+            fout.write(zeros, static_cast<std::streamsize>(table[k].offset - written));
+            fout.write(static_cast<const char*>(sections_[k].data), static_cast<std::streamsize>(sections_[k].size));
+            written = table[k].offset + sections_[k].size;
+        }
+        fout.write(zeros, static_cast<std::streamsize>(header.file_size - written));
+        if (!fout) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+bool IndexFile::open(const std::string& path, std::uint32_t kind, bool verify_data) {
+    file_ = FileView();
+
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) return false;
+
+    // 阈值为 0：总是 mmap，打开代价与文件大小无关
+    FileView file = read_file_view(path, 0);
+    std::string_view data = file.view;
+    if (data.size() < sizeof(IndexFileHeader)) return false;
+
+    const IndexFileHeader* h = reinterpret_cast<const IndexFileHeader*>(data.data());
+    if (std::memcmp(h->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || h->version != kIndexFormatVersion ||
+        h->endian != kIndexEndianMark || h->kind != kind || h->file_size != data.size()) {
+        return false;
+    }
+    size_t table_end = sizeof(IndexFileHeader) + size_t(h->section_count) * sizeof(IndexSection);
+    if (table_end > data.size()) return false;
+
+    const IndexSection* sections = reinterpret_cast<const IndexSection*>(data.data() + sizeof(IndexFileHeader));
+    if (header_checksum(*h, sections) != h->checksum) return false;
+    for (std::uint32_t k = 0; k < h->section_count; ++k) {
+        const IndexSection& s = sections[k];
+        if (s.offset % kSectionAlign != 0 || s.offset < table_end || s.offset > data.size() ||
+            s.size > data.size() - s.offset) {
+            return false;
+        }
+    }
+
+    file_ = std::move(file);
+    if (verify_data && !verify()) {
+        file_ = FileView();
+        return false;
+    }
+    return true;
+}
+
+bool IndexFile::verify() const {
+    if (!is_open()) return false;
+    const IndexSection* sections =
+        reinterpret_cast<const IndexSection*>(file_.view.data() + sizeof(IndexFileHeader));
+    for (std::uint32_t k = 0; k < header()->section_count; ++k) {
+        const IndexSection& s = sections[k];
+        if (index_checksum(file_.view.data() + s.offset, s.size) != s.checksum) return false;
+    }
+    return true;
+}
+
+const IndexSection* IndexFile::find(std::uint32_t tag) const {
+    if (!is_open()) return nullptr;
+    const IndexSection* sections =
+        reinterpret_cast<const IndexSection*>(file_.view.data() + sizeof(IndexFileHeader));
+    for (std::uint32_t k = 0; k < header()->section_count; ++k) {
+        if (sections[k].tag == tag) return &sections[k];
+    }
+    return nullptr;
+}
+
+bool IndexFile::bytes(std::uint32_t tag, std::string_view& out) const {
+    const IndexSection* section = find(tag);
+    if (section == nullptr) return false;
+    out = std::string_view(file_.view.data() + section->offset, section->size);
+    return true;
+}
@@ -1,36 +1,26 @@
 #include "matcher.hpp"
+#include "thread_pool.hpp"
+#include "tuning.hpp"
 #include <algorithm>
-#include <thread>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#ifdef __unix__
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using StrView = std::string_view;
-using MatchFnPtr = std::vector<int> (*)(StrView, StrView);
 
-std::vector<int> match_single_bf(StrView text, StrView pattern) {
-
-    std::vector<int> positions;
-
-    const size_t n = text.size();
-    const size_t m = pattern.size();
-
-    if (m == 0 || n < m) return positions;
-
-    for (size_t i = 0; i + m <= n; i++) {
-        bool flag = true;
-        for (size_t j = 0; j < m; j++) {
-            if (text[i + j] != pattern[j]) {
-                flag = false;
-                break;
-            }
-        }
-        if (flag) {
-            positions.push_back(static_cast<int>(i));
-        }
-    }
-
-    return positions;
+std::vector<MatchPos> match_single_bf(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BF).match(text);
 }
 
-std::vector<int> match_single(StrView text, StrView pattern) { return match_single_bf(text, pattern); }
+std::vector<MatchPos> match_single(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::Auto).match(text);
+}
 
 std::vector<int> compute_lps(StrView pattern) {
     int m = static_cast<int>(pattern.size());
@@ -56,96 +46,20 @@ std::vector<int> compute_lps(StrView pattern) {
     return lps;
 }
 
-std::vector<int> match_single_kmp(StrView text, StrView pattern) {
-    std::vector<int> positions;
-
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-
-    if (m == 0 || n < m) return positions;
-
-    std::vector<int> lps = compute_lps(pattern);
-
-    int i = 0;
-    int j = 0;
-
-    while (i < n) {
-
-        if (text[i] == pattern[j]) {
-            i++;
-            j++;
-
-            if (j == m) {
-                positions.push_back(i - m);
-                j = lps[j - 1];
-            }
-
-        } else {  // mismatch
-
-            if (j > 0) {
-                j = lps[j - 1];
-            } else {
-                i++;
-            }
-        }
-    }
-
-    return positions;
-}
-
-std::vector<int> match_single_sunday(StrView text, StrView pattern) {
-    std::vector<int> positions;
-
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-
-    if (m == 0 || n < m) return positions;
-
-    std::vector<int> shift(256, m + 1);
-
-    for (int i = 0; i < m; i++) {
-        shift[(unsigned char)pattern[i]] = m - i;
-    }
-
-    int i = 0;
-
-    while (i <= n - m) {
-        bool flag = true;
-
-        for (int j = 0; j < m; j++) {
-            if (text[i + j] != pattern[j]) {
-                flag = false;
-                break;
-            }
-        }
-
-        if (flag) {
-            positions.push_back(i);
-        }
-
-        if (i + m >= n) {
-            break;
-        }
-        i += shift[(unsigned char)text[i + m]];
-    }
-
-    return positions;
-}
-
 using ull = unsigned long long;
 const ull base = 131;
 
-ull compute_hash(StrView s, int m) {
+ull compute_hash(StrView s, size_t m) {
     ull h = 0;
-    for (int i = 0; i < m; i++) {
+    for (size_t i = 0; i < m; i++) {
         h = h * base + (unsigned char)s[i];
     }
     return h;
 }
 
-ull compute_power(int m) {
+ull compute_power(size_t m) {
     ull p = 1;
-    for (int i = 1; i < m; i++) {
+    for (size_t i = 1; i < m; i++) {
         p *= base;
     }
     return p;
@@ -161,44 +75,10 @@ ull roll_hash(ull old_hash, char old_char, char new_char, ull power) {
     return h;
 }
 
-std::vector<int> match_single_rk(StrView text, StrView pattern) {
-    std::vector<int> positions;
-
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-
-    if (m == 0 || n < m) return positions;
-
-    ull pattern_hash = compute_hash(pattern, m);
-    ull text_hash = compute_hash(text, m);
-    ull power = compute_power(m);
-
-    int i = 0;
-    while (i <= n - m) {
-        if (text_hash == pattern_hash) {
-            bool flag = true;
-            for (int j = 0; j < m; j++) {
-                if (text[i + j] != pattern[j]) {
-                    flag = false;
-                    break;
-                }
-            }
-            if (flag) {
-                positions.push_back(i);
-            }
-        }
-        if (i == n - m) break;
-        text_hash = roll_hash(text_hash, text[i], text[i + m], power);  // m>0因此i+1不会越界
-        i++;
-    }
-
-    return positions;
-}
-
-std::vector<int> match_single_bm_bc(StrView text, StrView pattern) {
-    std::vector<int> positions;
+std::vector<MatchPos> match_single_bm_bc(StrView text, StrView pattern) {
+    std::vector<MatchPos> positions;
 
-    int n = static_cast<int>(text.size());
+    MatchPos n = static_cast<MatchPos>(text.size());
     int m = static_cast<int>(pattern.size());
     if (m == 0 || n < m) return positions;
 
@@ -206,8 +86,10 @@ std::vector<int> match_single_bm_bc(StrView text, StrView pattern) {
     for (int k = 0; k < m; ++k) {
         last[(unsigned char)pattern[k]] = k;
     }
+    // 命中后按模式串的最小周期右移：更近的位置不可能再次命中
+    const int period = m - compute_lps(pattern).back();
 
-    int i = 0;
+    MatchPos i = 0;
     while (i <= n - m) {
         int j = m - 1;
 
@@ -218,7 +100,7 @@ std::vector<int> match_single_bm_bc(StrView text, StrView pattern) {
         if (j < 0) {
 
             positions.push_back(i);
-            i += 1;
+            i += period;
         } else {
             unsigned char bad = (unsigned char)text[i + j];
             int lo = last[bad];
@@ -233,9 +115,9 @@ std::vector<int> match_single_bm_bc(StrView text, StrView pattern) {
     return positions;
 }
 
-void build_bad_char(StrView pattern, std::vector<int>& bad_char) {
+void build_bad_char(StrView pattern, int* bad_char) {
     int m = static_cast<int>(pattern.size());
-    bad_char.assign(256, -1);
+    std::fill(bad_char, bad_char + 256, -1);
     for (int i = 0; i < m; ++i) {
         bad_char[(unsigned char)pattern[i]] = i;
     }
@@ -244,10 +126,10 @@ void build_bad_char(StrView pattern, std::vector<int>& bad_char) {
 // 构建好后缀（suffix / prefix）表
 // suffix[k]  = 长度为 k 的后缀子串（好后缀的“某个后缀”）在 pattern 中最右匹配的起始下标（不含末尾这次）
 // prefix[k]  = 长度为 k 的后缀子串是否同时是 pattern 的前缀
-void build_good_suffix(StrView pattern, std::vector<int>& suffix, std::vector<bool>& prefix) {
+void build_good_suffix(StrView pattern, std::vector<int>& suffix, std::vector<char>& prefix) {
     int m = static_cast<int>(pattern.size());
     suffix.assign(m, -1);
-    prefix.assign(m, false);
+    prefix.assign(m, 0);
 
     // 遍历 pattern[0..m-2]，尝试和以 pattern[m-1] 结尾的后缀对齐
     for (int i = 0; i < m - 1; ++i) {
@@ -264,13 +146,13 @@ void build_good_suffix(StrView pattern, std::vector<int>& suffix, std::vector<bo
 
         // 如果 j < 0，说明这一段前缀本身就是某个后缀（即“后缀又是前缀”）
         if (j < 0) {
-            prefix[k] = true;
+            prefix[k] = 1;
         }
     }
 }
 
 // 根据好后缀表计算在 mismatch 位置 j 时的位移
-int move_by_good_suffix(int j, int m, const std::vector<int>& suffix, const std::vector<bool>& prefix) {
+int move_by_good_suffix(int j, int m, const std::vector<int>& suffix, const std::vector<char>& prefix) {
     int k = m - 1 - j;  // 好后缀长度（已经匹配成功的尾巴长度）
 
     if (k <= 0) return 0;  // 没有好后缀时不由好后缀规则决定位移
@@ -291,455 +173,2045 @@ int move_by_good_suffix(int j, int m, const std::vector<int>& suffix, const std:
     return m;
 }
 
-// 完整 BM：坏字符 + 好后缀
-std::vector<int> match_single_bm(StrView text, StrView pattern) {
-    std::vector<int> positions;
-
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+// 匹配结果接收器：每个命中调用一次，返回 false 表示可以停止扫描
+namespace {
+struct CollectSink {
+    std::vector<MatchPos>& positions;
+    bool operator()(MatchPos pos) {
+        positions.push_back(pos);
+        return true;
+    }
+};
 
-    // 1. 构建坏字符表
-    std::vector<int> bad_char;
-    build_bad_char(pattern, bad_char);
+struct CountSink {
+    size_t count{0};
+    bool operator()(MatchPos) {
+        ++count;
+        return true;
+    }
+};
+
+// 写入调用方的定长缓冲区，写满即停止
+struct BufferSink {
+    MatchPos* out;
+    size_t capacity;
+    size_t size{0};
+    bool operator()(MatchPos pos) {
+        out[size++] = pos;
+        return size < capacity;
+    }
+};
+
+// 前 capacity 个写入定长缓冲区，其余追加到 rest，不停止扫描
+struct SplitSink {
+    MatchPos* head;
+    size_t capacity;
+    std::vector<MatchPos>& rest;
+    size_t count{0};
+    bool operator()(MatchPos pos) {
+        if (count < capacity) {
+            head[count] = pos;
+        } else {
+            rest.push_back(pos);
+        }
+        ++count;
+        return true;
+    }
+};
+
+// 只关心第一个命中：找到后立即停止
+struct FirstSink {
+    MatchPos pos{-1};
+    bool operator()(MatchPos p) {
+        pos = p;
+        return false;
+    }
+};
+}  // namespace
 
-    // 2. 构建好后缀表
-    std::vector<int> suffix;
-    std::vector<bool> prefix;
-    build_good_suffix(pattern, suffix, prefix);
+// SIMD 子串匹配：把模式串首字节、尾字节分别广播，与文本中对应偏移的 16/32 字节块同时比较，
+// 只对两者都相等的候选位置做完整校验。运行时按 CPU 特性选择 AVX2 / SSE2 / 可移植实现。
+namespace {
+enum class SimdLevel { Generic, SSE2, AVX2 };
 
-    // 3. 主循环：i 为窗口左端
-    int i = 0;
-    while (i <= n - m) {
-        int j = m - 1;
+// 从 from 开始逐位置匹配，处理向量块覆盖不到的尾部
+template <typename Sink> void simd_tail(StrView text, StrView pattern, size_t from, MatchPos offset, Sink& sink) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    for (size_t i = from; i + m <= n; ++i) {
+        if (text[i] == pattern[0] && std::memcmp(text.data() + i, pattern.data(), m) == 0) {
+            if (!sink(offset + static_cast<MatchPos>(i))) return;
+        }
+    }
+}
 
-        // 从右往左匹配
-        while (j >= 0 && pattern[j] == text[i + j]) {
-            --j;
+// 可移植实现：memchr 定位首字节（libc 内部已向量化），再校验尾字节与中间部分
+template <typename Sink> void simd_kernel_generic(StrView text, StrView pattern, MatchPos offset, Sink& sink) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const char* base_ptr = text.data();
+    const char* limit = base_ptr + (n - m) + 1;
+    const char first = pattern[0];
+    const char last = pattern[m - 1];
+
+    for (const char* p = base_ptr; p < limit;) {
+        p = static_cast<const char*>(std::memchr(p, first, limit - p));
+        if (!p) break;
+        if (p[m - 1] == last && std::memcmp(p + 1, pattern.data() + 1, m > 2 ? m - 2 : 0) == 0) {
+            if (!sink(offset + static_cast<MatchPos>(p - base_ptr))) return;
         }
+        ++p;
+    }
+}
 
-        if (j < 0) {
-            // 匹配成功
-            positions.push_back(i);
-            // 这里简单起见，右移 1（也可以用好后缀/整串位移优化）
-            i += 1;
-        } else {
-            // 坏字符规则
-            unsigned char bad = (unsigned char)text[i + j];
-            int last_pos = bad_char[bad];  // 该坏字符在 pattern 中最后一次出现的位置（-1 表示不存在）
-            int shift_bc = j - last_pos;   // 标准坏字符位移
-            if (shift_bc < 1) shift_bc = 1;
+#if defined(__x86_64__) || defined(__i386__)
+// 对候选位掩码逐位校验（首尾字节已相等，只比较中间 m-2 字节）；返回 false 表示接收器要求停止
+template <typename Sink>
+inline bool simd_verify(StrView text, StrView pattern, size_t i, unsigned mask, MatchPos offset, Sink& sink) {
+    const size_t m = pattern.size();
+    while (mask != 0) {
+        unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+        size_t pos = i + bit;
+        if (m <= 2 || std::memcmp(text.data() + pos + 1, pattern.data() + 1, m - 2) == 0) {
+            if (!sink(offset + static_cast<MatchPos>(pos))) return false;
+        }
+        mask &= mask - 1;
+    }
+    return true;
+}
 
-            // 好后缀规则
-            int shift_gs = move_by_good_suffix(j, m, suffix, prefix);
+template <typename Sink>
+__attribute__((target("sse2"))) void simd_kernel_sse2(StrView text, StrView pattern, MatchPos offset, Sink& sink) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[m - 1]);
+
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + m - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0 && !simd_verify(text, pattern, i, mask, offset, sink)) return;
+    }
+    simd_tail(text, pattern, i, offset, sink);
+}
 
-            // 取两者较大者
-            int shift = std::max(shift_bc, shift_gs);
-            i += shift;
-        }
+template <typename Sink>
+__attribute__((target("avx2"))) void simd_kernel_avx2(StrView text, StrView pattern, MatchPos offset, Sink& sink) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i + m - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask != 0 && !simd_verify(text, pattern, i, mask, offset, sink)) return;
     }
+    simd_tail(text, pattern, i, offset, sink);
+}
+#endif
+
+SimdLevel detect_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Generic;
+}
 
-    return positions;
+const SimdLevel g_simd_level = detect_simd_level();
+
+template <typename Sink> void simd_scan(StrView text, StrView pattern, MatchPos offset, Sink& sink) {
+    switch (g_simd_level) {
+#if defined(__x86_64__) || defined(__i386__)
+    case SimdLevel::AVX2:
+        simd_kernel_avx2(text, pattern, offset, sink);
+        return;
+    case SimdLevel::SSE2:
+        simd_kernel_sse2(text, pattern, offset, sink);
+        return;
+#endif
+    default:
+        simd_kernel_generic(text, pattern, offset, sink);
+        return;
+    }
 }
+}  // namespace
 
+// ---------------- 位并行内核（Shift-Or / BNDM）与 BOM ----------------
+// 三者都只处理模式串的前 w = min(m, 128) 字节（窗口），更长的模式串在窗口命中后比较剩余部分。
+// 位并行状态按窗口长度选字宽：w <= 64 用一个机器字，否则用 128 位向量（SSE2，不可用时为两个 64 位字）
 namespace {
-template <typename MatchFunc>
-std::vector<int> parallel_match_impl(StrView text, StrView pattern, int num_threads, MatchFunc match_func) {
-    std::vector<int> positions;
+constexpr size_t kBitWindow = 128;
+
+struct Word64Ops {
+    using Word = std::uint64_t;
+    static constexpr size_t kWords = 1;  // 每个字节掩码占用的 uint64 个数
+
+    static Word load(const std::uint64_t* masks, unsigned char c) { return masks[c]; }
+    static Word ones(size_t w) { return w >= 64 ? ~Word(0) : (Word(1) << w) - 1; }
+    static Word bit(size_t k) { return Word(1) << k; }
+    static Word shl1(Word x) { return x << 1; }
+    static Word and_(Word a, Word b) { return a & b; }
+    static Word or_(Word a, Word b) { return a | b; }
+    static bool any(Word x) { return x != 0; }
+};
+
+#if defined(__SSE2__)
+struct Word128Ops {
+    using Word = __m128i;
+    static constexpr size_t kWords = 2;
+
+    static Word load(const std::uint64_t* masks, unsigned char c) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + 2 * static_cast<size_t>(c)));
+    }
+    static Word from_parts(std::uint64_t lo, std::uint64_t hi) {
+        return _mm_set_epi64x(static_cast<long long>(hi), static_cast<long long>(lo));
+    }
+    static Word ones(size_t w) {
+        return from_parts(w >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << w) - 1,
+                          w >= 128 ? ~std::uint64_t(0) : (w > 64 ? (std::uint64_t(1) << (w - 64)) - 1 : 0));
+    }
+    static Word bit(size_t k) {
+        return k < 64 ? from_parts(std::uint64_t(1) << k, 0) : from_parts(0, std::uint64_t(1) << (k - 64));
+    }
+    // 128 位整体左移一位：各 64 位半字左移，低半字的最高位进到高半字
+    static Word shl1(Word x) {
+        Word carry = _mm_slli_si128(_mm_srli_epi64(x, 63), 8);
+        return _mm_or_si128(_mm_slli_epi64(x, 1), carry);
+    }
+    static Word and_(Word a, Word b) { return _mm_and_si128(a, b); }
+    static Word or_(Word a, Word b) { return _mm_or_si128(a, b); }
+    static bool any(Word x) { return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF; }
+};
+#else
+struct Word128Ops {
+    struct Word {
+        std::uint64_t lo, hi;
+    };
+    static constexpr size_t kWords = 2;
 
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
+    static Word load(const std::uint64_t* masks, unsigned char c) {
+        return Word{masks[2 * static_cast<size_t>(c)], masks[2 * static_cast<size_t>(c) + 1]};
+    }
+    static Word ones(size_t w) {
+        return Word{w >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << w) - 1,
+                    w >= 128 ? ~std::uint64_t(0) : (w > 64 ? (std::uint64_t(1) << (w - 64)) - 1 : 0)};
+    }
+    static Word bit(size_t k) {
+        return k < 64 ? Word{std::uint64_t(1) << k, 0} : Word{0, std::uint64_t(1) << (k - 64)};
+    }
+    static Word shl1(Word x) { return Word{x.lo << 1, (x.hi << 1) | (x.lo >> 63)}; }
+    static Word and_(Word a, Word b) { return Word{a.lo & b.lo, a.hi & b.hi}; }
+    static Word or_(Word a, Word b) { return Word{a.lo | b.lo, a.hi | b.hi}; }
+    static bool any(Word x) { return (x.lo | x.hi) != 0; }
+};
+#endif
+
+// 字节掩码表：masks[c] 的第 k 位对应窗口中的一个位置。Shift-Or 按 pattern[k] != c 置位（0 表示匹配），
+// BNDM 按 pattern[w-1-k] == c 置位（反向读取窗口）
+void build_bit_masks(StrView pattern, size_t w, bool shift_or, std::vector<std::uint64_t>& masks) {
+    const size_t words = w <= 64 ? 1 : 2;
+    masks.assign(256 * words, shift_or ? ~std::uint64_t(0) : 0);
+    for (size_t k = 0; k < w; ++k) {
+        const unsigned char c = static_cast<unsigned char>(pattern[k]);
+        const size_t bit = shift_or ? k : w - 1 - k;
+        std::uint64_t& word = masks[c * words + bit / 64];
+        if (shift_or) {
+            word &= ~(std::uint64_t(1) << (bit % 64));
+        } else {
+            word |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+}
 
-    if (m == 0 || n < m) return positions;
+// 窗口之后的剩余部分
+inline bool tail_matches(const char* text, StrView pattern, size_t w) {
+    return pattern.size() == w || std::memcmp(text + w, pattern.data() + w, pattern.size() - w) == 0;
+}
 
-    num_threads = std::min(num_threads, n / std::max(1, m));
-    if (num_threads <= 0) num_threads = 1;
+// Shift-Or：D = (D << 1) | masks[c]，第 w-1 位为 0 时窗口在当前字节结束处命中。每字节一次查表和两次位运算，没有分支跳转
+template <typename Ops, typename Sink>
+void shift_or_kernel(StrView text, StrView pattern, const std::uint64_t* masks, MatchPos offset, Sink& sink) {
+    using Word = typename Ops::Word;
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const size_t w = std::min(m, kBitWindow);
+    const Word high = Ops::bit(w - 1);
+    const char* data = text.data();
+
+    Word state = Ops::ones(kBitWindow);
+    // 命中起点不超过 n - m，窗口终点不超过 n - m + w - 1
+    const size_t stop = n - m + w;
+    for (size_t i = 0; i < stop; ++i) {
+        state = Ops::or_(Ops::shl1(state), Ops::load(masks, static_cast<unsigned char>(data[i])));
+        if (!Ops::any(Ops::and_(state, high))) {
+            const size_t start = i + 1 - w;
+            if (tail_matches(data + start, pattern, w) && !sink(offset + static_cast<MatchPos>(start))) return;
+        }
+    }
+}
 
-    int chunk_size = n / num_threads;
+// BNDM：从窗口右端向左读，用位并行的后缀自动机判断读过的部分是否仍是模式串的子串；
+// 第 w-1 位置位表示读过的部分是模式串前缀，记下最近的前缀位置作为下一次的移动距离
+template <typename Ops, typename Sink>
+void bndm_kernel(StrView text, StrView pattern, const std::uint64_t* masks, MatchPos offset, Sink& sink) {
+    using Word = typename Ops::Word;
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const size_t w = std::min(m, kBitWindow);
+    const Word high = Ops::bit(w - 1);
+    const Word full = Ops::ones(w);
+    const char* data = text.data();
+
+    size_t pos = 0;
+    while (pos + m <= n) {
+        size_t j = w;
+        size_t last = w;
+        Word state = full;
+        for (;;) {
+            state = Ops::and_(state, Ops::load(masks, static_cast<unsigned char>(data[pos + j - 1])));
+            --j;
+            if (Ops::any(Ops::and_(state, high))) {
+                if (j > 0) {
+                    last = j;
+                } else if (tail_matches(data + pos, pattern, w) && !sink(offset + static_cast<MatchPos>(pos))) {
+                    return;
+                }
+            }
+            if (j == 0) break;
+            state = Ops::shl1(state);
+            if (!Ops::any(state)) break;
+        }
+        pos += last;
+    }
+}
 
-    std::vector<std::vector<int>> all_positions(num_threads);
-    std::vector<std::thread> threads;
-    threads.reserve(num_threads);
+// BOM 的转移表：窗口反串的 factor oracle，(w + 1) 个状态 × 256 字节，kNoState 表示没有转移
+constexpr std::uint8_t kNoState = 0xFF;
+
+void build_factor_oracle(StrView pattern, size_t w, std::vector<std::uint8_t>& oracle) {
+    oracle.assign((w + 1) * 256, kNoState);
+    std::vector<int> supply(w + 1, -1);
+    for (size_t i = 0; i < w; ++i) {
+        const unsigned char c = static_cast<unsigned char>(pattern[w - 1 - i]);
+        oracle[i * 256 + c] = static_cast<std::uint8_t>(i + 1);
+        int k = supply[i];
+        while (k >= 0 && oracle[static_cast<size_t>(k) * 256 + c] == kNoState) {
+            oracle[static_cast<size_t>(k) * 256 + c] = static_cast<std::uint8_t>(i + 1);
+            k = supply[k];
+        }
+        supply[i + 1] = k < 0 ? 0 : oracle[static_cast<size_t>(k) * 256 + c];
+    }
+}
 
-    for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
-        int start = thread_id * chunk_size;
-        int end = (thread_id == num_threads - 1) ? n : (thread_id + 1) * chunk_size;
-        end = std::min(end + (m - 1), n);
+// BOM：从窗口右端向左沿 oracle 转移，无转移时读过的部分不是模式串的子串，窗口越过失配字节；
+// 读完整个窗口时 oracle 可能多接受，需比较确认
+template <typename Sink>
+void bom_kernel(StrView text, StrView pattern, const std::uint8_t* oracle, MatchPos offset, Sink& sink) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const size_t w = std::min(m, kBitWindow);
+    const char* data = text.data();
+
+    size_t pos = 0;
+    while (pos + m <= n) {
+        size_t state = 0;
+        size_t j = w;
+        while (j > 0) {
+            const std::uint8_t next = oracle[state * 256 + static_cast<unsigned char>(data[pos + j - 1])];
+            if (next == kNoState) break;
+            state = next;
+            --j;
+        }
+        if (j == 0) {
+            if (std::memcmp(data + pos, pattern.data(), m) == 0 && !sink(offset + static_cast<MatchPos>(pos))) return;
+            pos += 1;
+        } else {
+            pos += j;
+        }
+    }
+}
+}  // namespace
 
-        threads.emplace_back([&, thread_id, start, end]() {
-            StrView segment = text.substr(start, end - start);
-            auto local_pos = match_func(segment, pattern);
-            for (int p : local_pos) {
-                all_positions[thread_id].push_back(start + p);
+// ---------------- Two-Way 临界分解 ----------------
+// 按字节序（reverse 为 false）或其逆序求 pattern 的最大后缀，返回其起点的前一个下标，period 为该后缀的周期。
+// 两种序下较靠右的那个起点即临界分解位置（Crochemore–Perrin），只需常数额外空间
+MatchPos maximal_suffix(StrView pattern, bool reverse, MatchPos& period) {
+    const MatchPos m = static_cast<MatchPos>(pattern.size());
+    MatchPos ms = -1;  // 当前最大后缀起点的前一个下标
+    MatchPos j = 0;
+    MatchPos k = 1;
+    period = 1;
+    while (j + k < m) {
+        const unsigned char a = static_cast<unsigned char>(pattern[j + k]);
+        const unsigned char b = static_cast<unsigned char>(pattern[ms + k]);
+        if (reverse ? a > b : a < b) {
+            j += k;
+            k = 1;
+            period = j - ms;
+        } else if (a == b) {
+            if (k != period) {
+                ++k;
+            } else {
+                j += period;
+                k = 1;
             }
-        });
+        } else {
+            ms = j;
+            j = ms + 1;
+            k = period = 1;
+        }
     }
+    return ms;
+}
 
-    for (auto& th : threads) th.join();
+// ---------------- 预编译模式串 ----------------
 
-    for (auto& vec : all_positions) {
-        positions.insert(positions.end(), vec.begin(), vec.end());
-    }
+CompiledPattern::CompiledPattern(StrView pattern, MatchAlgo algo) : algo_(algo), pattern_(pattern) {
+    if (algo_ == MatchAlgo::Auto) algo_ = choose_algo(pattern_);
 
-    std::sort(positions.begin(), positions.end());
-    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    const int m = static_cast<int>(pattern_.size());
+    if (m == 0) return;
 
-    return positions;
+    switch (algo_) {
+    case MatchAlgo::KMP:
+        table_ = compute_lps(pattern_);
+        break;
+    case MatchAlgo::Sunday:
+        table_.assign(256, m + 1);
+        for (int i = 0; i < m; i++) {
+            table_[(unsigned char)pattern_[i]] = m - i;
+        }
+        break;
+    case MatchAlgo::RK:
+        hash_ = compute_hash(pattern_, pattern_.size());
+        power_ = compute_power(pattern_.size());
+        break;
+    case MatchAlgo::BM: {
+        // [0, 256) 坏字符表，[256, 256 + m) 每个失配位置 j 的好后缀位移
+        table_.resize(256 + m);
+        build_bad_char(pattern_, table_.data());
+        std::vector<int> suffix;
+        std::vector<char> prefix;
+        build_good_suffix(pattern_, suffix, prefix);
+        for (int j = 0; j < m; ++j) {
+            table_[256 + j] = move_by_good_suffix(j, m, suffix, prefix);
+        }
+        period_ = m - compute_lps(pattern_).back();
+        break;
+    }
+    case MatchAlgo::TwoWay: {
+        MatchPos period = 1;
+        MatchPos reverse_period = 1;
+        const MatchPos ms = maximal_suffix(pattern_, false, period);
+        const MatchPos reverse_ms = maximal_suffix(pattern_, true, reverse_period);
+        critical_ = std::max(ms, reverse_ms);
+        period_ = ms > reverse_ms ? period : reverse_period;
+        // 左半部分 [0, critical_] 在周期 period_ 下重复出现时，命中后只移一个周期并记住已匹配的前缀；
+        // 否则任何位移都不小于两半中较长者，直接按它移动
+        periodic_ = period_ + critical_ + 1 <= m &&
+                    std::memcmp(pattern_.data(), pattern_.data() + period_, static_cast<size_t>(critical_ + 1)) == 0;
+        if (!periodic_) period_ = std::max<MatchPos>(critical_ + 1, m - critical_ - 1) + 1;
+        break;
+    }
+    case MatchAlgo::ShiftOr:
+    case MatchAlgo::BNDM:
+        build_bit_masks(pattern_, std::min(pattern_.size(), kBitWindow), algo_ == MatchAlgo::ShiftOr, masks_);
+        break;
+    case MatchAlgo::BOM:
+        build_factor_oracle(pattern_, std::min(pattern_.size(), kBitWindow), oracle_);
+        break;
+    case MatchAlgo::BF:
+    case MatchAlgo::SIMD:
+    case MatchAlgo::Auto:
+        break;
+    }
 }
-}  // namespace
 
-std::vector<int> match_parallel(StrView text, StrView pattern, int num_threads) {
-    return match_parallel_bf(text, pattern, num_threads);
+std::vector<MatchPos> CompiledPattern::match(StrView text) const {
+    std::vector<MatchPos> positions;
+    match(text, 0, positions);
+    return positions;
 }
 
-std::vector<int> match_parallel_bf(StrView text, StrView pattern, int num_threads) {
-    return parallel_match_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(match_single_bf));
+void CompiledPattern::match(StrView text, MatchPos offset, std::vector<MatchPos>& positions) const {
+    CollectSink sink{positions};
+    scan(text, offset, sink);
 }
 
-std::vector<int> match_parallel_kmp(StrView text, StrView pattern, int num_threads) {
-    return parallel_match_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(match_single_kmp));
+size_t CompiledPattern::count(StrView text) const {
+    CountSink sink;
+    scan(text, 0, sink);
+    return sink.count;
 }
 
-std::vector<int> match_parallel_sunday(StrView text, StrView pattern, int num_threads) {
-    return parallel_match_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(match_single_sunday));
+MatchPos CompiledPattern::find_first(StrView text) const {
+    FirstSink sink;
+    scan(text, 0, sink);
+    return sink.pos;
 }
 
-std::vector<int> match_parallel_rk(StrView text, StrView pattern, int num_threads) {
-    return parallel_match_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(match_single_rk));
-}
+void CompiledPattern::for_each(StrView text, MatchPos offset, MatchVisitor visit) const { scan(text, offset, visit); }
 
-std::vector<int> match_parallel_bm(StrView text, StrView pattern, int num_threads) {
-    return parallel_match_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(match_single_bm));
+size_t CompiledPattern::match_into(StrView text, MatchPos offset, MatchPos* out, size_t capacity) const {
+    if (capacity == 0) return 0;
+    BufferSink sink{out, capacity};
+    scan(text, offset, sink);
+    return sink.size;
 }
 
-// 兼容 std::string 的包装
-std::vector<int> match_single(const std::string& text, const std::string& pattern) {
-    return match_single(StrView(text), StrView(pattern));
-}
-std::vector<int> match_single_bf(const std::string& text, const std::string& pattern) {
-    return match_single_bf(StrView(text), StrView(pattern));
-}
-std::vector<int> match_single_kmp(const std::string& text, const std::string& pattern) {
-    return match_single_kmp(StrView(text), StrView(pattern));
-}
-std::vector<int> match_single_sunday(const std::string& text, const std::string& pattern) {
-    return match_single_sunday(StrView(text), StrView(pattern));
-}
-std::vector<int> match_single_rk(const std::string& text, const std::string& pattern) {
-    return match_single_rk(StrView(text), StrView(pattern));
-}
-std::vector<int> match_single_bm(const std::string& text, const std::string& pattern) {
-    return match_single_bm(StrView(text), StrView(pattern));
+size_t CompiledPattern::match_split(StrView text, MatchPos offset, MatchPos* head, size_t capacity,
+                                    std::vector<MatchPos>& rest) const {
+    SplitSink sink{head, capacity, rest};
+    scan(text, offset, sink);
+    return sink.count;
 }
 
-std::vector<int> match_parallel(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel(StrView(text), StrView(pattern), num_threads);
-}
-std::vector<int> match_parallel_bf(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel_bf(StrView(text), StrView(pattern), num_threads);
-}
-std::vector<int> match_parallel_kmp(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel_kmp(StrView(text), StrView(pattern), num_threads);
-}
-std::vector<int> match_parallel_sunday(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel_sunday(StrView(text), StrView(pattern), num_threads);
-}
-std::vector<int> match_parallel_rk(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel_rk(StrView(text), StrView(pattern), num_threads);
-}
-std::vector<int> match_parallel_bm(const std::string& text, const std::string& pattern, int num_threads) {
-    return match_parallel_bm(StrView(text), StrView(pattern), num_threads);
+template <typename Sink> void CompiledPattern::scan(StrView text, MatchPos offset, Sink& sink) const {
+    const size_t n = text.size();
+    const size_t m = pattern_.size();
+
+    if (m == 0 || n < m) return;
+
+    switch (algo_) {
+    case MatchAlgo::BF:
+        scan_bf(text, offset, sink);
+        break;
+    case MatchAlgo::KMP:
+        scan_kmp(text, offset, sink);
+        break;
+    case MatchAlgo::Sunday:
+        scan_sunday(text, offset, sink);
+        break;
+    case MatchAlgo::RK:
+        scan_rk(text, offset, sink);
+        break;
+    case MatchAlgo::BM:
+        scan_bm(text, offset, sink);
+        break;
+    case MatchAlgo::TwoWay:
+        scan_two_way(text, offset, sink);
+        break;
+    case MatchAlgo::ShiftOr:
+        if (std::min(m, kBitWindow) <= 64) {
+            shift_or_kernel<Word64Ops>(text, pattern_, masks_.data(), offset, sink);
+        } else {
+            shift_or_kernel<Word128Ops>(text, pattern_, masks_.data(), offset, sink);
+        }
+        break;
+    case MatchAlgo::BNDM:
+        if (std::min(m, kBitWindow) <= 64) {
+            bndm_kernel<Word64Ops>(text, pattern_, masks_.data(), offset, sink);
+        } else {
+            bndm_kernel<Word128Ops>(text, pattern_, masks_.data(), offset, sink);
+        }
+        break;
+    case MatchAlgo::BOM:
+        bom_kernel(text, pattern_, oracle_.data(), offset, sink);
+        break;
+    case MatchAlgo::SIMD:
+    case MatchAlgo::Auto:  // 构造时已解析为具体算法
+        simd_scan(text, pattern_, offset, sink);
+        break;
+    }
 }
 
-std::vector<int> binary_match_single(StrView text, StrView pattern) {
-    std::vector<int> positions;
-
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-
-    if (m == 0 || n < m) return positions;
+template <typename Sink> void CompiledPattern::scan_bf(StrView text, MatchPos offset, Sink& sink) const {
+    const size_t n = text.size();
+    const size_t m = pattern_.size();
 
-    for (int i = 0; i <= n - m; i++) {
+    for (size_t i = 0; i + m <= n; i++) {
         bool flag = true;
-        for (int j = 0; j < m; j++) {
-            if (text[i + j] != pattern[j]) {
+        for (size_t j = 0; j < m; j++) {
+            if (text[i + j] != pattern_[j]) {
                 flag = false;
                 break;
             }
         }
         if (flag) {
-            positions.push_back(i);
+            if (!sink(offset + static_cast<MatchPos>(i))) return;
         }
     }
-    return positions;
 }
 
-std::vector<int> binary_match_single(const std::vector<char>& text, const std::vector<char>& pattern) {
-    return binary_match_single(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
-}
+template <typename Sink> void CompiledPattern::scan_kmp(StrView text, MatchPos offset, Sink& sink) const {
+    const MatchPos n = static_cast<MatchPos>(text.size());
+    const MatchPos m = static_cast<MatchPos>(pattern_.size());
+    const int* lps = table_.data();
 
-std::vector<int> binary_match_single_kmp(StrView text, StrView pattern) {
-    std::vector<int> positions;
+    MatchPos i = 0;
+    MatchPos j = 0;
 
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+    while (i < n) {
 
-    // 构建 lps
-    std::vector<int> lps(m, 0);
-    for (int i = 1, len = 0; i < m;) {
-        if (pattern[i] == pattern[len]) {
-            lps[i++] = ++len;
-        } else if (len > 0) {
-            len = lps[len - 1];
-        } else {
-            lps[i++] = 0;
-        }
-    }
+        if (text[i] == pattern_[j]) {
+            i++;
+            j++;
 
-    for (int i = 0, j = 0; i < n;) {
-        if (text[i] == pattern[j]) {
-            ++i;
-            ++j;
             if (j == m) {
-                positions.push_back(i - m);
+                if (!sink(offset + i - m)) return;
                 j = lps[j - 1];
             }
-        } else if (j > 0) {
-            j = lps[j - 1];
-        } else {
-            ++i;
+
+        } else {  // mismatch
+
+            if (j > 0) {
+                j = lps[j - 1];
+            } else {
+                i++;
+            }
         }
     }
-
-    return positions;
 }
 
-std::vector<int> binary_match_single_kmp(const std::vector<char>& text, const std::vector<char>& pattern) {
-    return binary_match_single_kmp(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
-}
+template <typename Sink> void CompiledPattern::scan_sunday(StrView text, MatchPos offset, Sink& sink) const {
+    const MatchPos n = static_cast<MatchPos>(text.size());
+    const MatchPos m = static_cast<MatchPos>(pattern_.size());
+    const int* shift = table_.data();
 
-std::vector<int> binary_match_single_sunday(StrView text, StrView pattern) {
-    std::vector<int> positions;
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+    MatchPos i = 0;
 
-    std::vector<int> shift(256, m + 1);
-    for (int i = 0; i < m; ++i) {
-        shift[(unsigned char)pattern[i]] = m - i;
-    }
+    while (i <= n - m) {
+        bool flag = true;
 
-    for (int i = 0; i <= n - m;) {
-        bool ok = true;
-        for (int j = 0; j < m; ++j) {
-            if (text[i + j] != pattern[j]) {
-                ok = false;
+        for (MatchPos j = 0; j < m; j++) {
+            if (text[i + j] != pattern_[j]) {
+                flag = false;
                 break;
             }
         }
-        if (ok) positions.push_back(i);
-        if (i + m >= n) break;
+
+        if (flag) {
+            if (!sink(offset + i)) return;
+        }
+
+        if (i + m >= n) {
+            break;
+        }
         i += shift[(unsigned char)text[i + m]];
     }
-    return positions;
 }
 
-std::vector<int> binary_match_single_sunday(const std::vector<char>& text, const std::vector<char>& pattern) {
-    return binary_match_single_sunday(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
-}
+template <typename Sink> void CompiledPattern::scan_rk(StrView text, MatchPos offset, Sink& sink) const {
+    const MatchPos n = static_cast<MatchPos>(text.size());
+    const MatchPos m = static_cast<MatchPos>(pattern_.size());
 
-std::vector<int> binary_match_single_rk(StrView text, StrView pattern) {
-    std::vector<int> positions;
+    ull text_hash = compute_hash(text, pattern_.size());
 
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+    MatchPos i = 0;
+    while (i <= n - m) {
+        if (text_hash == hash_) {
+            bool flag = true;
+            for (MatchPos j = 0; j < m; j++) {
+                if (text[i + j] != pattern_[j]) {
+                    flag = false;
+                    break;
+                }
+            }
+            if (flag) {
+                if (!sink(offset + i)) return;
+            }
+        }
+        if (i == n - m) break;
+        text_hash = roll_hash(text_hash, text[i], text[i + m], power_);  // m>0因此i+1不会越界
+        i++;
+    }
+}
 
-    auto compute_hash_vec = [&](StrView arr, int start, int len) {
-        ull h = 0;
-        for (int i = 0; i < len; ++i) {
-            h = h * base + (unsigned char)arr[start + i];
+// 完整 BM：坏字符 + 好后缀
+template <typename Sink> void CompiledPattern::scan_bm(StrView text, MatchPos offset, Sink& sink) const {
+    const MatchPos n = static_cast<MatchPos>(text.size());
+    const MatchPos m = static_cast<MatchPos>(pattern_.size());
+    const int* bad_char = table_.data();
+    const int* good_suffix = table_.data() + 256;
+
+    // i 为窗口左端；known 为窗口开头已知与模式串一致的字节数（Galil 规则，命中后按周期移动时有效）
+    MatchPos i = 0;
+    MatchPos known = 0;
+    while (i <= n - m) {
+        MatchPos j = m - 1;
+
+        // 从右往左匹配，已知一致的前缀不再比较
+        while (j >= known && pattern_[j] == text[i + j]) {
+            --j;
         }
-        return h;
-    };
 
-    ull pattern_hash = compute_hash_vec(pattern, 0, m);
-    ull text_hash = compute_hash_vec(text, 0, m);
+        if (j < known) {
+            // 匹配成功
+            if (!sink(offset + i)) return;
+            // 按最小周期右移：新窗口的前 m - period 字节正是刚匹配过的尾部，重复文本上保持线性
+            i += period_;
+            known = m - period_;
+        } else {
+            known = 0;
+            // 坏字符规则
+            unsigned char bad = (unsigned char)text[i + j];
+            int last_pos = bad_char[bad];  // 该坏字符在 pattern 中最后一次出现的位置（-1 表示不存在）
+            MatchPos shift_bc = j - last_pos; // 标准坏字符位移
+            if (shift_bc < 1) shift_bc = 1;
+
+            // 好后缀规则（预先按失配位置展开）
+            int shift_gs = good_suffix[j];
 
-    ull power = 1;
-    for (int i = 1; i < m; ++i) power *= base;
+            // 取两者较大者
+            MatchPos shift = std::max<MatchPos>(shift_bc, shift_gs);
+            i += shift;
+        }
+    }
+}
 
-    for (int i = 0; i <= n - m; ++i) {
-        if (text_hash == pattern_hash) {
-            bool ok = true;
-            for (int j = 0; j < m; ++j) {
-                if (text[i + j] != pattern[j]) {
-                    ok = false;
-                    break;
-                }
+// Two-Way：先从临界位置向右比较右半部分，失配时按已匹配长度移动；右半部分全部一致后再向左比较左半部分。
+// 周期情形下命中（或左半部分失配）后只移动一个周期，并用 memory 记住新窗口开头已知一致的部分，
+// 因此每个文本字节至多比较常数次，最坏情况 O(n + m)
+template <typename Sink> void CompiledPattern::scan_two_way(StrView text, MatchPos offset, Sink& sink) const {
+    const MatchPos n = static_cast<MatchPos>(text.size());
+    const MatchPos m = static_cast<MatchPos>(pattern_.size());
+    const char* x = pattern_.data();
+    const char* y = text.data();
+    const MatchPos ell = critical_;
+    const MatchPos per = period_;
+
+    MatchPos j = 0;
+    if (periodic_) {
+        MatchPos memory = -1;
+        while (j <= n - m) {
+            MatchPos i = std::max(ell, memory) + 1;
+            while (i < m && x[i] == y[i + j]) ++i;
+            if (i < m) {
+                j += i - ell;
+                memory = -1;
+                continue;
             }
-            if (ok) positions.push_back(i);
+            i = ell;
+            while (i > memory && x[i] == y[i + j]) --i;
+            if (i <= memory && !sink(offset + j)) return;
+            j += per;
+            memory = m - per - 1;
+        }
+    } else {
+        while (j <= n - m) {
+            MatchPos i = ell + 1;
+            while (i < m && x[i] == y[i + j]) ++i;
+            if (i < m) {
+                j += i - ell;
+                continue;
+            }
+            i = ell;
+            while (i >= 0 && x[i] == y[i + j]) --i;
+            if (i < 0 && !sink(offset + j)) return;
+            j += per;
         }
-        if (i == n - m) break;
-        text_hash = roll_hash(text_hash, text[i], text[i + m], power);
     }
+}
+
+std::vector<MatchPos> match_single_kmp(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::KMP).match(text);
+}
+
+std::vector<MatchPos> match_single_sunday(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::Sunday).match(text);
+}
+
+std::vector<MatchPos> match_single_rk(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::RK).match(text);
+}
+
+std::vector<MatchPos> match_single_bm(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BM).match(text);
+}
+
+std::vector<MatchPos> match_single_simd(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::SIMD).match(text);
+}
+
+std::vector<MatchPos> match_single_shift_or(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::ShiftOr).match(text);
+}
+
+std::vector<MatchPos> match_single_bndm(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BNDM).match(text);
+}
+
+std::vector<MatchPos> match_single_bom(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BOM).match(text);
+}
+
+std::vector<MatchPos> match_single_two_way(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::TwoWay).match(text);
+}
+
+namespace {
+constexpr size_t kDefaultChunkSize = 1 << 20;
+std::atomic<size_t> g_chunk_size{kDefaultChunkSize};
+std::atomic<size_t> g_tile_size{0};  // 0 表示按 L2 容量取默认值
+
+size_t default_tile_size() {
+#if defined(__unix__) && defined(_SC_LEVEL2_CACHE_SIZE)
+    const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0) return static_cast<size_t>(l2) / 2;
+#endif
+    return 256 << 10;
+}
+
+// 分块方案：workers 路并发，每块 chunk 字节（最后一块可能较短），共 count 块
+struct ChunkPlan {
+    int workers;
+    size_t chunk;
+    size_t count;
+};
+
+// 与原先的静态切分一致，并发度不超过 n / m；块大小不超过 match_chunk_size()，
+// 且保证至少切出 workers 块，小文本退化为按线程数等分。
+ChunkPlan plan_chunks(size_t n, size_t m, int num_threads) {
+    ChunkPlan plan{};
+    size_t limit = n / std::max<size_t>(1, m);
+    plan.workers = static_cast<int>(std::min<size_t>(std::max(num_threads, 1), std::max<size_t>(limit, 1)));
+
+    size_t even = (n + plan.workers - 1) / plan.workers;
+    plan.chunk = std::max<size_t>(1, std::min(match_chunk_size(), even));
+    plan.count = (n + plan.chunk - 1) / plan.chunk;
+    return plan;
+}
+
+// 每块直接写入共享暂存数组的命中数上限：稀疏文本中绝大多数块的命中都放得下，不为这些块分配内存
+constexpr size_t kChunkHeadHits = 64;
+
+// 文本与二进制共用：预处理表只在 pattern 编译时构建一次，各块只读共享。
+// 只有一块时直接写入 positions。否则各块扫描一遍，前 kChunkHeadHits 个命中写入一次性分配的共享暂存数组，
+// 只有更密的块把其余命中另存（不重新扫描：密集模式串重扫一遍的代价远高于拷贝）；按各块命中数的前缀和
+// 一次性扩容 positions，再并行把各块拷贝到各自的最终区间
+size_t parallel_match_impl(StrView text, const CompiledPattern& pattern, int num_threads,
+                           std::vector<MatchPos>& positions) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    const size_t before = positions.size();
+
+    if (m == 0 || n < m) return 0;
+
+    ChunkPlan plan = plan_chunks(n, m, num_threads);
+    if (plan.count == 1) {
+        pattern.match(text, 0, positions);
+        return positions.size() - before;
+    }
+
+    std::vector<MatchPos> heads(plan.count * kChunkHeadHits);
+    std::vector<std::vector<MatchPos>> spills(plan.count);
+    std::vector<size_t> counts(plan.count, 0);
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        size_t start = chunk_id * plan.chunk;
+        size_t end = std::min(start + plan.chunk, n);
+        end = std::min(end + (m - 1), n);
+
+        counts[chunk_id] = pattern.match_split(text.substr(start, end - start), static_cast<MatchPos>(start),
+                                               heads.data() + chunk_id * kChunkHeadHits, kChunkHeadHits,
+                                               spills[chunk_id]);
+    });
+
+    std::vector<size_t> offsets(plan.count + 1, before);
+    for (size_t k = 0; k < plan.count; ++k) offsets[k + 1] = offsets[k] + counts[k];
+    positions.resize(offsets[plan.count]);
+
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        const MatchPos* head = heads.data() + chunk_id * kChunkHeadHits;
+        MatchPos* dst = positions.data() + offsets[chunk_id];
+        dst = std::copy(head, head + std::min(counts[chunk_id], kChunkHeadHits), dst);
+        std::copy(spills[chunk_id].begin(), spills[chunk_id].end(), dst);
+        std::vector<MatchPos>().swap(spills[chunk_id]);
+    });
+    return positions.size() - before;
+}
+
+std::vector<MatchPos> parallel_match_impl(StrView text, const CompiledPattern& pattern, int num_threads) {
+    std::vector<MatchPos> positions;
+    parallel_match_impl(text, pattern, num_threads, positions);
     return positions;
 }
 
-std::vector<int> binary_match_single_rk(const std::vector<char>& text, const std::vector<char>& pattern) {
-    return binary_match_single_rk(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+// 只统计命中次数：各块独立计数后求和，不生成位置数组
+size_t parallel_count_impl(StrView text, const CompiledPattern& pattern, int num_threads) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+
+    if (m == 0 || n < m) return 0;
+
+    ChunkPlan plan = plan_chunks(n, m, num_threads);
+    std::atomic<size_t> total{0};
+
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        size_t start = chunk_id * plan.chunk;
+        size_t end = std::min(start + plan.chunk, n);
+        end = std::min(end + (m - 1), n);
+
+        total.fetch_add(pattern.count(text.substr(start, end - start)), std::memory_order_relaxed);
+    });
+    return total.load();
 }
 
-std::vector<int> binary_match_single_bm(StrView text, StrView pattern) {
-    std::vector<int> positions;
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+// 查找第一个命中：某块命中后把派发上限收缩到该块，之后的块不再扫描；
+// 更靠前的块此时都已被领取，会照常完成，因此结果仍是全局最小位置。
+MatchPos parallel_first_impl(StrView text, const CompiledPattern& pattern, int num_threads) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
 
-    std::vector<int> bad_char(256, -1);
-    for (int i = 0; i < m; ++i) bad_char[(unsigned char)pattern[i]] = i;
+    if (m == 0 || n < m) return -1;
 
-    std::vector<int> suffix(m, -1);
-    std::vector<bool> prefix(m, false);
-    // build_good_suffix for vector<char>
-    for (int i = 0; i < m - 1; ++i) {
-        int j = i;
-        int k = 0;
-        while (j >= 0 && pattern[j] == pattern[m - 1 - k]) {
-            --j;
-            ++k;
-            suffix[k] = j + 1;
-        }
-        if (j < 0) prefix[k] = true;
+    ChunkPlan plan = plan_chunks(n, m, num_threads);
+    std::vector<MatchPos> first_in_chunk(plan.count, -1);
+    std::atomic<size_t> limit{plan.count};
+
+    parallel_for_dynamic(
+        plan.count, plan.workers,
+        [&](size_t chunk_id) {
+            size_t start = chunk_id * plan.chunk;
+            size_t end = std::min(start + plan.chunk, n);
+            end = std::min(end + (m - 1), n);
+
+            MatchPos pos = pattern.find_first(text.substr(start, end - start));
+            if (pos < 0) return;
+            first_in_chunk[chunk_id] = static_cast<MatchPos>(start) + pos;
+
+            size_t cur = limit.load();
+            while (chunk_id + 1 < cur && !limit.compare_exchange_weak(cur, chunk_id + 1)) {
+            }
+        },
+        &limit);
+
+    for (MatchPos pos : first_in_chunk) {
+        if (pos >= 0) return pos;
     }
+    return -1;
+}
+}  // namespace
 
-    auto move_by_good_suffix_vec = [&](int j) {
-        int k = m - 1 - j;
-        if (k <= 0) return 0;
-        if (suffix[k] != -1) return j + 1 - suffix[k];
-        for (int r = k - 1; r > 0; --r) {
-            if (prefix[r]) return m - r;
+MatchResult match_parallel(StrView text, const CompiledPattern& pattern, int num_threads, MatchMode mode) {
+    MatchResult result;
+    switch (mode) {
+    case MatchMode::All:
+        result.positions = parallel_match_impl(text, pattern, num_threads);
+        result.count = result.positions.size();
+        break;
+    case MatchMode::Count:
+        result.count = parallel_count_impl(text, pattern, num_threads);
+        break;
+    case MatchMode::FindFirst: {
+        MatchPos pos = parallel_first_impl(text, pattern, num_threads);
+        if (pos >= 0) {
+            result.positions.push_back(pos);
+            result.count = 1;
         }
-        return m;
-    };
+        break;
+    }
+    }
+    return result;
+}
 
-    for (int i = 0; i <= n - m;) {
-        int j = m - 1;
-        while (j >= 0 && pattern[j] == text[i + j]) --j;
-        if (j < 0) {
-            positions.push_back(i);
-            i += 1;
+bool match_exists(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return parallel_first_impl(text, pattern, num_threads) >= 0;
+}
+
+size_t match_count(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return parallel_count_impl(text, pattern, num_threads);
+}
+
+void set_match_chunk_size(size_t bytes) { g_chunk_size.store(bytes == 0 ? kDefaultChunkSize : bytes); }
+
+size_t match_chunk_size() { return g_chunk_size.load(); }
+
+BatchStrategy choose_batch_strategy(size_t text_size, size_t pattern_count, int num_threads) {
+    const int threads = std::min(std::max(num_threads, 1), ThreadPool::instance().worker_count() + 1);
+    if (pattern_count <= 1 || choose_threads(text_size, threads) >= threads) return BatchStrategy::Text;
+    if (pattern_count >= static_cast<size_t>(threads)) return BatchStrategy::Patterns;
+    return BatchStrategy::Both;
+}
+
+std::vector<std::vector<MatchPos>> match_batch(StrView text, const std::vector<CompiledPattern>& patterns,
+                                               const BatchOptions& options) {
+    const int threads = std::max(options.num_threads, 1);
+    BatchStrategy strategy = options.strategy;
+    if (strategy == BatchStrategy::Auto) strategy = choose_batch_strategy(text.size(), patterns.size(), threads);
+
+    if (strategy == BatchStrategy::Text) {
+        return match_parallel_tiled(text, patterns, choose_threads(text.size(), threads));
+    }
+
+    std::vector<std::vector<MatchPos>> positions(patterns.size());
+    if (patterns.empty()) return positions;
+    const int across = static_cast<int>(std::min<size_t>(patterns.size(), threads));
+    // Both：剩余的并发度分给每个模式串的文本分块（嵌套任务同样提交到共享线程池，等待时帮忙执行）
+    const int within = strategy == BatchStrategy::Both ? std::max(1, threads / across) : 1;
+    parallel_for_dynamic(patterns.size(), across, [&](size_t k) {
+        if (within == 1) {
+            patterns[k].match(text, 0, positions[k]);
         } else {
-            unsigned char bad = (unsigned char)text[i + j];
-            int shift_bc = j - bad_char[bad];
-            if (shift_bc < 1) shift_bc = 1;
-            int shift_gs = move_by_good_suffix_vec(j);
-            i += std::max(shift_bc, shift_gs);
+            match_parallel(text, patterns[k], within, positions[k]);
         }
-    }
+    });
     return positions;
 }
 
-std::vector<int> binary_match_single_bm(const std::vector<char>& text, const std::vector<char>& pattern) {
-    return binary_match_single_bm(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+void set_match_tile_size(size_t bytes) { g_tile_size.store(bytes); }
+
+size_t match_tile_size() {
+    static const size_t fallback = default_tile_size();
+    const size_t bytes = g_tile_size.load();
+    return bytes == 0 ? fallback : bytes;
 }
 
-namespace {
-template <typename MatchFunc>
-std::vector<int> parallel_binary_impl(StrView text, StrView pattern, int num_threads, MatchFunc match_func) {
-    std::vector<int> positions;
+std::vector<std::vector<MatchPos>> match_parallel_tiled(StrView text, const std::vector<CompiledPattern>& patterns,
+                                                        int num_threads) {
+    const size_t n = text.size();
+    std::vector<std::vector<MatchPos>> positions(patterns.size());
+    if (n == 0 || patterns.empty()) return positions;
+
+    const size_t tile = std::max<size_t>(1, match_tile_size());
+    const size_t tiles = (n + tile - 1) / tile;
+    const int workers = static_cast<int>(std::min<size_t>(std::max(num_threads, 1), tiles));
+
+    // partial[w][k]：工作者 w 负责的块中模式串 k 的命中。每块同样只向右多扫描 m-1 字节，
+    // 命中起点不越出本块，同一模式串的结果按工作者顺序拼接即为升序
+    std::vector<std::vector<std::vector<MatchPos>>> partial(
+        workers, std::vector<std::vector<MatchPos>>(patterns.size()));
+    parallel_for(workers, [&](int w) {
+        const size_t first = tiles * w / workers;
+        const size_t last = tiles * (w + 1) / workers;
+        for (size_t t = first; t < last; ++t) {
+            const size_t start = t * tile;
+            const size_t end = std::min(start + tile, n);
+            for (size_t k = 0; k < patterns.size(); ++k) {
+                const size_t m = patterns[k].size();
+                if (m == 0 || start + m > n) continue;
+                const size_t stop = std::min(end + (m - 1), n);
+                patterns[k].match(text.substr(start, stop - start), static_cast<MatchPos>(start), partial[w][k]);
+            }
+        }
+    });
 
-    int n = static_cast<int>(text.size());
-    int m = static_cast<int>(pattern.size());
-    if (m == 0 || n < m) return positions;
+    parallel_for_dynamic(patterns.size(), workers, [&](size_t k) {
+        if (workers == 1) {
+            positions[k] = std::move(partial[0][k]);
+            return;
+        }
+        size_t total = 0;
+        for (int w = 0; w < workers; ++w) total += partial[w][k].size();
+        positions[k].reserve(total);
+        for (int w = 0; w < workers; ++w) {
+            positions[k].insert(positions[k].end(), partial[w][k].begin(), partial[w][k].end());
+            std::vector<MatchPos>().swap(partial[w][k]);
+        }
+    });
+    return positions;
+}
+
+std::vector<MatchPos> match_parallel(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return parallel_match_impl(text, pattern, num_threads);
+}
 
-    num_threads = std::min(num_threads, n / std::max(1, m));
-    if (num_threads <= 0) num_threads = 1;
+size_t match_parallel(StrView text, const CompiledPattern& pattern, int num_threads,
+                      std::vector<MatchPos>& positions) {
+    return parallel_match_impl(text, pattern, num_threads, positions);
+}
 
-    int chunk_size = n / num_threads;
+void match_parallel(StrView text, const CompiledPattern& pattern, int num_threads, MatchVisitor visit) {
+    const size_t n = text.size();
+    const size_t m = pattern.size();
+    if (m == 0 || n < m) return;
 
-    std::vector<std::vector<int>> all_positions(num_threads);
-    std::vector<std::thread> threads;
-    threads.reserve(num_threads);
+    ChunkPlan plan = plan_chunks(n, m, num_threads);
+    if (plan.count == 1) {
+        pattern.for_each(text, 0, visit);
+        return;
+    }
 
-    for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
-        int start = thread_id * chunk_size;
-        int end = (thread_id == num_threads - 1) ? n : (thread_id + 1) * chunk_size;
+    // 按块顺序分轮推进，每轮 workers 块：调用线程扫描本轮第一块并直接回调 visit，其余块并行收集到可复用的槽位，
+    // 本轮结束后按顺序回调。暂存的命中最多 workers-1 块，visit 返回 false 后停止回调，正在扫描的块也随之停下，
+    // 之后的块不再派发
+    const size_t wave = static_cast<size_t>(plan.workers);
+    std::vector<std::vector<MatchPos>> slots(wave);
+    std::atomic<bool> stop{false};
+    auto chunk_text = [&](size_t chunk_id) {
+        size_t start = chunk_id * plan.chunk;
+        size_t end = std::min(start + plan.chunk, n);
         end = std::min(end + (m - 1), n);
+        return text.substr(start, end - start);
+    };
 
-        threads.emplace_back([&, thread_id, start, end]() {
-            StrView segment = text.substr(start, end - start);
-            auto local_pos = match_func(segment, pattern);
-            for (int p : local_pos) all_positions[thread_id].push_back(start + p);
+    for (size_t first = 0; first < plan.count && !stop.load(); first += wave) {
+        const size_t count = std::min(wave, plan.count - first);
+        parallel_for(static_cast<int>(count), [&](int k) {
+            const size_t chunk_id = first + static_cast<size_t>(k);
+            const MatchPos start = static_cast<MatchPos>(chunk_id * plan.chunk);
+            if (k == 0) {
+                pattern.for_each(chunk_text(chunk_id), start, [&](MatchPos pos) {
+                    if (visit(pos)) return true;
+                    stop.store(true, std::memory_order_relaxed);
+                    return false;
+                });
+                return;
+            }
+            std::vector<MatchPos>& slot = slots[static_cast<size_t>(k)];
+            slot.clear();
+            if (stop.load(std::memory_order_relaxed)) return;
+            pattern.for_each(chunk_text(chunk_id), start, [&](MatchPos pos) {
+                slot.push_back(pos);
+                return !stop.load(std::memory_order_relaxed);
+            });
         });
+        for (size_t k = 1; k < count && !stop.load(); ++k) {
+            for (MatchPos pos : slots[k]) {
+                if (!visit(pos)) {
+                    stop.store(true);
+                    break;
+                }
+            }
+        }
     }
+}
 
-    for (auto& th : threads) th.join();
+// 默认入口：按模式串、文本大小与线程数自动选择算法和并发度
+std::vector<MatchPos> match_parallel(StrView text, StrView pattern, int num_threads) {
+    MatchStrategy strategy = choose_strategy(pattern, text.size(), num_threads);
+    return parallel_match_impl(text, CompiledPattern(pattern, strategy.algo), strategy.threads);
+}
 
-    for (auto& vec : all_positions) positions.insert(positions.end(), vec.begin(), vec.end());
-    std::sort(positions.begin(), positions.end());
-    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
-    return positions;
+std::vector<MatchPos> match_parallel_bf(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BF), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_kmp(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::KMP), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_sunday(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::Sunday), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_rk(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::RK), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_bm(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BM), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_simd(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::SIMD), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_shift_or(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::ShiftOr), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_bndm(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BNDM), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_bom(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BOM), num_threads);
+}
+
+std::vector<MatchPos> match_parallel_two_way(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::TwoWay), num_threads);
+}
+
+// 兼容 std::string 的包装
+std::vector<MatchPos> match_single(const std::string& text, const std::string& pattern) {
+    return match_single(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_bf(const std::string& text, const std::string& pattern) {
+    return match_single_bf(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_kmp(const std::string& text, const std::string& pattern) {
+    return match_single_kmp(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_sunday(const std::string& text, const std::string& pattern) {
+    return match_single_sunday(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_rk(const std::string& text, const std::string& pattern) {
+    return match_single_rk(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_bm(const std::string& text, const std::string& pattern) {
+    return match_single_bm(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_simd(const std::string& text, const std::string& pattern) {
+    return match_single_simd(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_shift_or(const std::string& text, const std::string& pattern) {
+    return match_single_shift_or(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_bndm(const std::string& text, const std::string& pattern) {
+    return match_single_bndm(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_bom(const std::string& text, const std::string& pattern) {
+    return match_single_bom(StrView(text), StrView(pattern));
+}
+std::vector<MatchPos> match_single_two_way(const std::string& text, const std::string& pattern) {
+    return match_single_two_way(StrView(text), StrView(pattern));
+}
+
+std::vector<MatchPos> match_parallel(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_bf(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_bf(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_kmp(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_kmp(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_sunday(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_sunday(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_rk(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_rk(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_bm(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_bm(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_simd(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_simd(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_shift_or(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_shift_or(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_bndm(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_bndm(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_bom(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_bom(StrView(text), StrView(pattern), num_threads);
+}
+std::vector<MatchPos> match_parallel_two_way(const std::string& text, const std::string& pattern, int num_threads) {
+    return match_parallel_two_way(StrView(text), StrView(pattern), num_threads);
+}
+
+// 二进制匹配与文本匹配共用同一组按字节比较的内核
+std::vector<MatchPos> binary_match_single(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::Auto).match(text);
+}
+
+std::vector<MatchPos> binary_match_single(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_kmp(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::KMP).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_kmp(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_kmp(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_sunday(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::Sunday).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_sunday(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_sunday(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_rk(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::RK).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_rk(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_rk(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_bm(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BM).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_bm(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_bm(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_simd(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::SIMD).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_simd(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_simd(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_shift_or(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::ShiftOr).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_shift_or(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_shift_or(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_bndm(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BNDM).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_bndm(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_bndm(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_bom(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::BOM).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_bom(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_bom(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_single_two_way(StrView text, StrView pattern) {
+    return CompiledPattern(pattern, MatchAlgo::TwoWay).match(text);
+}
+
+std::vector<MatchPos> binary_match_single_two_way(const std::vector<char>& text, const std::vector<char>& pattern) {
+    return binary_match_single_two_way(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()));
+}
+
+std::vector<MatchPos> binary_match_parallel(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return parallel_match_impl(text, pattern, num_threads);
+}
+
+bool binary_match_exists(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return match_exists(text, pattern, num_threads);
+}
+
+size_t binary_match_count(StrView text, const CompiledPattern& pattern, int num_threads) {
+    return match_count(text, pattern, num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel(StrView text, StrView pattern, int num_threads) {
+    MatchStrategy strategy = choose_strategy(pattern, text.size(), num_threads);
+    return parallel_match_impl(text, CompiledPattern(pattern, strategy.algo), strategy.threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_bf(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BF), num_threads);
 }
-}  // namespace
 
-std::vector<int> binary_match_parallel(StrView text, StrView pattern, int num_threads) {
-    return binary_match_parallel_bf(text, pattern, num_threads);
+std::vector<MatchPos> binary_match_parallel_kmp(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::KMP), num_threads);
 }
 
-std::vector<int> binary_match_parallel_bf(StrView text, StrView pattern, int num_threads) {
-    return parallel_binary_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(binary_match_single));
+std::vector<MatchPos> binary_match_parallel_sunday(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::Sunday), num_threads);
 }
 
-std::vector<int> binary_match_parallel_kmp(StrView text, StrView pattern, int num_threads) {
-    return parallel_binary_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(binary_match_single_kmp));
+std::vector<MatchPos> binary_match_parallel_rk(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::RK), num_threads);
 }
 
-std::vector<int> binary_match_parallel_sunday(StrView text, StrView pattern, int num_threads) {
-    return parallel_binary_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(binary_match_single_sunday));
+std::vector<MatchPos> binary_match_parallel_bm(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BM), num_threads);
 }
 
-std::vector<int> binary_match_parallel_rk(StrView text, StrView pattern, int num_threads) {
-    return parallel_binary_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(binary_match_single_rk));
+std::vector<MatchPos> binary_match_parallel_simd(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::SIMD), num_threads);
 }
 
-std::vector<int> binary_match_parallel_bm(StrView text, StrView pattern, int num_threads) {
-    return parallel_binary_impl(text, pattern, num_threads, static_cast<MatchFnPtr>(binary_match_single_bm));
+std::vector<MatchPos> binary_match_parallel_shift_or(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::ShiftOr), num_threads);
 }
 
-std::vector<int> binary_match_parallel(const std::vector<char>& text, const std::vector<char>& pattern,
-                                       int num_threads) {
+std::vector<MatchPos> binary_match_parallel_bndm(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BNDM), num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_bom(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::BOM), num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_two_way(StrView text, StrView pattern, int num_threads) {
+    return parallel_match_impl(text, CompiledPattern(pattern, MatchAlgo::TwoWay), num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel(const std::vector<char>& text, const std::vector<char>& pattern,
+                                            int num_threads) {
     return binary_match_parallel(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                  num_threads);
 }
 
-std::vector<int> binary_match_parallel_bf(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads) {
+std::vector<MatchPos> binary_match_parallel_bf(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads) {
     return binary_match_parallel_bf(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                     num_threads);
 }
 
-std::vector<int> binary_match_parallel_kmp(const std::vector<char>& text, const std::vector<char>& pattern,
-                                           int num_threads) {
+std::vector<MatchPos> binary_match_parallel_kmp(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                int num_threads) {
     return binary_match_parallel_kmp(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                      num_threads);
 }
 
-std::vector<int> binary_match_parallel_sunday(const std::vector<char>& text, const std::vector<char>& pattern,
-                                              int num_threads) {
+std::vector<MatchPos> binary_match_parallel_sunday(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                   int num_threads) {
     return binary_match_parallel_sunday(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                         num_threads);
 }
 
-std::vector<int> binary_match_parallel_rk(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads) {
+std::vector<MatchPos> binary_match_parallel_rk(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads) {
     return binary_match_parallel_rk(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                     num_threads);
 }
 
-std::vector<int> binary_match_parallel_bm(const std::vector<char>& text, const std::vector<char>& pattern,
-                                          int num_threads) {
+std::vector<MatchPos> binary_match_parallel_bm(const std::vector<char>& text, const std::vector<char>& pattern,
+                                               int num_threads) {
     return binary_match_parallel_bm(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
                                     num_threads);
 }
+
+std::vector<MatchPos> binary_match_parallel_simd(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                 int num_threads) {
+    return binary_match_parallel_simd(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
+                                      num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_shift_or(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                     int num_threads) {
+    return binary_match_parallel_shift_or(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
+                                          num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_bndm(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                 int num_threads) {
+    return binary_match_parallel_bndm(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
+                                      num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_bom(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                int num_threads) {
+    return binary_match_parallel_bom(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
+                                     num_threads);
+}
+
+std::vector<MatchPos> binary_match_parallel_two_way(const std::vector<char>& text, const std::vector<char>& pattern,
+                                                    int num_threads) {
+    return binary_match_parallel_two_way(StrView(text.data(), text.size()), StrView(pattern.data(), pattern.size()),
+                                         num_threads);
+}
+
+AhoCorasick::AhoCorasick(const std::vector<std::string>& patterns) {
+    std::vector<StrView> views(patterns.begin(), patterns.end());
+    build(views);
+}
+
+AhoCorasick::AhoCorasick(const std::vector<StrView>& patterns) { build(patterns); }
+
+struct AhoCorasick::Tables {
+    std::vector<int> next, depth, term, report, out_link, unique_len, pattern_ids;
+};
+
+void AhoCorasick::build(const std::vector<StrView>& patterns) {
+    // 1. 字节等价类：模式串中出现过的字节各占一类，其余字节共用一类
+    bool used[256] = {};
+    max_len_ = 0;
+    for (StrView p : patterns) {
+        for (char c : p) used[(unsigned char)c] = true;
+        max_len_ = std::max(max_len_, p.size());
+    }
+    int cls = 0;
+    for (int b = 0; b < 256; ++b) {
+        if (used[b]) byte_class_[b] = static_cast<unsigned char>(cls++);
+    }
+    if (cls < 256) {
+        for (int b = 0; b < 256; ++b) {
+            if (!used[b]) byte_class_[b] = static_cast<unsigned char>(cls);
+        }
+        ++cls;
+    }
+    num_classes_ = cls;
+
+    // 2. 构建 trie，转移表直接使用扁平数组，-1 表示暂无边
+    auto tables = std::make_shared<Tables>();
+    Tables& tbl = *tables;
+    tbl.next.assign(num_classes_, -1);
+    tbl.depth.assign(1, 0);
+    tbl.term.assign(1, -1);
+    tbl.unique_len.clear();
+    tbl.pattern_ids.assign(patterns.size(), -1);
+
+    for (size_t idx = 0; idx < patterns.size(); ++idx) {
+        StrView p = patterns[idx];
+        if (p.empty()) continue;
+
+        int state = 0;
+        for (char c : p) {
+            int& slot = tbl.next[static_cast<size_t>(state) * num_classes_ + byte_class_[(unsigned char)c]];
+            if (slot == -1) {
+                slot = static_cast<int>(tbl.depth.size());
+                tbl.depth.push_back(tbl.depth[state] + 1);
+                tbl.term.push_back(-1);
+                tbl.next.resize(tbl.next.size() + num_classes_, -1);
+            }
+            // resize 之后 slot 引用可能失效，重新读取
+            state = tbl.next[static_cast<size_t>(state) * num_classes_ + byte_class_[(unsigned char)c]];
+        }
+        if (tbl.term[state] == -1) {
+            tbl.term[state] = static_cast<int>(tbl.unique_len.size());
+            tbl.unique_len.push_back(static_cast<int>(p.size()));
+        }
+        tbl.pattern_ids[idx] = tbl.term[state];
+    }
+
+    // 3. BFS 计算 fail 链，同时把缺失的边补全为完整 DFA
+    const size_t states = tbl.depth.size();
+    std::vector<int> fail(states, 0);
+    tbl.out_link.assign(states, -1);
+    tbl.report.assign(states, -1);
+
+    std::vector<int> queue;
+    queue.reserve(states);
+    for (int c = 0; c < num_classes_; ++c) {
+        int& t = tbl.next[c];
+        if (t == -1) {
+            t = 0;
+        } else {
+            fail[t] = 0;
+            queue.push_back(t);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int s = queue[head];
+        int f = fail[s];
+        tbl.out_link[s] = (tbl.term[f] != -1) ? f : tbl.out_link[f];
+
+        const size_t row = static_cast<size_t>(s) * num_classes_;
+        const size_t frow = static_cast<size_t>(f) * num_classes_;
+        for (int c = 0; c < num_classes_; ++c) {
+            int t = tbl.next[row + c];
+            if (t == -1) {
+                tbl.next[row + c] = tbl.next[frow + c];
+            } else {
+                fail[t] = tbl.next[frow + c];
+                queue.push_back(t);
+            }
+        }
+    }
+
+    for (size_t s = 0; s < states; ++s) {
+        tbl.report[s] = (tbl.term[s] != -1) ? static_cast<int>(s) : tbl.out_link[s];
+    }
+
+    storage_ = tables;
+    next_ = tbl.next;
+    depth_ = tbl.depth;
+    term_ = tbl.term;
+    report_ = tbl.report;
+    out_link_ = tbl.out_link;
+    unique_len_ = tbl.unique_len;
+    pattern_ids_ = tbl.pattern_ids;
+}
+
+// 扫描 [start, scan_end)，只记录起点落在 [start, end) 内的命中，按结束位置顺序追加 (去重后编号, 起点)
+void AhoCorasick::scan_range(StrView text, size_t start, size_t end, std::vector<Hit>& hits) const {
+    const size_t n = text.size();
+    const size_t scan_end = std::min(n, end + (max_len_ > 0 ? max_len_ - 1 : 0));
+    const int* next = next_.data();
+    const size_t classes = static_cast<size_t>(num_classes_);
+
+    int state = 0;
+    for (size_t i = start; i < scan_end; ++i) {
+        // 越过块尾后，若当前状态已无法延伸出起点在块内的命中，则提前结束
+        if (i >= end && static_cast<size_t>(depth_[state]) <= i - end) break;
+
+        state = next[static_cast<size_t>(state) * classes + byte_class_[(unsigned char)text[i]]];
+
+        for (int o = report_[state]; o != -1; o = out_link_[o]) {
+            int id = term_[o];
+            size_t pos = i + 1 - static_cast<size_t>(unique_len_[id]);
+            if (pos < end) hits.emplace_back(id, static_cast<MatchPos>(pos));
+        }
+    }
+}
+
+// 把各块的命中按块顺序分发到各模式串；同一模式串的命中在块内按起点升序，块间天然有序
+std::vector<std::vector<MatchPos>> AhoCorasick::gather_results(std::vector<std::vector<Hit>>& chunk_hits) const {
+    std::vector<std::vector<MatchPos>> unique_results(unique_len_.size());
+    std::vector<size_t> counts(unique_len_.size(), 0);
+    for (const auto& hits : chunk_hits) {
+        for (const auto& hit : hits) ++counts[hit.first];
+    }
+    for (size_t id = 0; id < counts.size(); ++id) unique_results[id].reserve(counts[id]);
+    for (auto& hits : chunk_hits) {
+        for (const auto& hit : hits) unique_results[hit.first].push_back(hit.second);
+        std::vector<Hit>().swap(hits);
+    }
+    return expand_results(unique_results);
+}
+
+std::vector<std::vector<MatchPos>> AhoCorasick::expand_results(std::vector<std::vector<MatchPos>>& unique_results) const {
+    std::vector<std::vector<MatchPos>> results(pattern_ids_.size());
+    // 重复模式串需要各自一份结果，最后一次引用时直接移动
+    std::vector<int> last_use(unique_results.size(), -1);
+    for (size_t idx = 0; idx < pattern_ids_.size(); ++idx) {
+        if (pattern_ids_[idx] != -1) last_use[pattern_ids_[idx]] = static_cast<int>(idx);
+    }
+    for (size_t idx = 0; idx < pattern_ids_.size(); ++idx) {
+        int id = pattern_ids_[idx];
+        if (id == -1) continue;
+        if (last_use[id] == static_cast<int>(idx)) {
+            results[idx] = std::move(unique_results[id]);
+        } else {
+            results[idx] = unique_results[id];
+        }
+    }
+    return results;
+}
+
+std::vector<std::vector<MatchPos>> AhoCorasick::match(StrView text) const {
+    std::vector<std::vector<Hit>> chunk_hits(1);
+    if (!unique_len_.empty()) scan_range(text, 0, text.size(), chunk_hits[0]);
+    return gather_results(chunk_hits);
+}
+
+std::vector<std::vector<MatchPos>> AhoCorasick::match_parallel(StrView text, int num_threads) const {
+    std::vector<std::vector<Hit>> chunk_hits;
+
+    const size_t n = text.size();
+    if (unique_len_.empty() || n == 0) return gather_results(chunk_hits);
+
+    ChunkPlan plan = plan_chunks(n, max_len_, num_threads);
+    chunk_hits.resize(plan.count);
+
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        size_t start = chunk_id * plan.chunk;
+        size_t end = std::min(start + plan.chunk, text.size());
+        scan_range(text, start, end, chunk_hits[chunk_id]);
+    });
+
+    return gather_results(chunk_hits);
+}
+
+// 扫描 [start, end) 起点范围内的命中，只记录每个模式串是否出现；seen/found 在所有块间共享，全部出现后各块都提前结束
+void AhoCorasick::scan_present(StrView text, size_t start, size_t end, std::atomic<unsigned char>* seen,
+                               std::atomic<size_t>& found) const {
+    const size_t n = text.size();
+    const size_t scan_end = std::min(n, end + (max_len_ > 0 ? max_len_ - 1 : 0));
+    const size_t unique_count = unique_len_.size();
+    const int* next = next_.data();
+    const size_t classes = static_cast<size_t>(num_classes_);
+
+    if (found.load(std::memory_order_relaxed) == unique_count) return;
+
+    int state = 0;
+    for (size_t i = start; i < scan_end; ++i) {
+        if (i >= end && static_cast<size_t>(depth_[state]) <= i - end) break;
+
+        state = next[static_cast<size_t>(state) * classes + byte_class_[(unsigned char)text[i]]];
+
+        for (int o = report_[state]; o != -1; o = out_link_[o]) {
+            int id = term_[o];
+            if (seen[id].load(std::memory_order_relaxed)) continue;
+            if (i + 1 - static_cast<size_t>(unique_len_[id]) >= end) continue;
+            if (seen[id].exchange(1, std::memory_order_relaxed)) continue;
+            if (found.fetch_add(1, std::memory_order_relaxed) + 1 == unique_count) return;
+        }
+    }
+}
+
+std::vector<int> AhoCorasick::find_present(StrView text, int num_threads) const {
+    std::vector<int> present;
+    const size_t unique_count = unique_len_.size();
+
+    const size_t n = text.size();
+    if (unique_count == 0 || n == 0) return present;
+
+    ChunkPlan plan = plan_chunks(n, max_len_, num_threads);
+
+    std::unique_ptr<std::atomic<unsigned char>[]> seen(new std::atomic<unsigned char>[unique_count]);
+    for (size_t id = 0; id < unique_count; ++id) seen[id].store(0, std::memory_order_relaxed);
+    std::atomic<size_t> found{0};
+
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        size_t start = chunk_id * plan.chunk;
+        size_t end = std::min(start + plan.chunk, text.size());
+        scan_present(text, start, end, seen.get(), found);
+    });
+
+    for (size_t idx = 0; idx < pattern_ids_.size(); ++idx) {
+        int id = pattern_ids_[idx];
+        if (id != -1 && seen[id].load(std::memory_order_relaxed)) present.push_back(static_cast<int>(idx));
+    }
+    return present;
+}
+
+int AhoCorasick::scan_stream(int state, StrView chunk, MatchPos base,
+                             std::vector<std::vector<MatchPos>>& results) const {
+    if (unique_len_.empty()) return state;
+
+    const int* next = next_.data();
+    const size_t classes = static_cast<size_t>(num_classes_);
+
+    // 命中可以起始于之前的分段，起点为负偏移相对 base
+    std::vector<Hit> hits;
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        state = next[static_cast<size_t>(state) * classes + byte_class_[(unsigned char)chunk[i]]];
+
+        for (int o = report_[state]; o != -1; o = out_link_[o]) {
+            int id = term_[o];
+            hits.emplace_back(id, base + static_cast<MatchPos>(i + 1) - unique_len_[id]);
+        }
+    }
+    if (hits.empty()) return state;
+
+    std::vector<std::vector<Hit>> chunk_hits(1);
+    chunk_hits[0].swap(hits);
+    std::vector<std::vector<MatchPos>> chunk_results = gather_results(chunk_hits);
+    for (size_t idx = 0; idx < chunk_results.size(); ++idx) {
+        results[idx].insert(results[idx].end(), chunk_results[idx].begin(), chunk_results[idx].end());
+    }
+    return state;
+}
+
+namespace {
+constexpr std::uint32_t kAutomatonIndexKind = index_tag("ACAU");
+constexpr std::uint32_t kTagAcMeta = index_tag("ACMT");
+constexpr std::uint32_t kTagAcClass = index_tag("ACBC");
+constexpr std::uint32_t kTagAcNext = index_tag("ACNX");
+constexpr std::uint32_t kTagAcDepth = index_tag("ACDP");
+constexpr std::uint32_t kTagAcTerm = index_tag("ACTM");
+constexpr std::uint32_t kTagAcReport = index_tag("ACRP");
+constexpr std::uint32_t kTagAcOutLink = index_tag("ACOL");
+constexpr std::uint32_t kTagAcUniqueLen = index_tag("ACUL");
+constexpr std::uint32_t kTagAcPatternIds = index_tag("ACPI");
+
+bool all_in_range(ConstSpan<int> values, int lo, int hi) {
+    for (int v : values) {
+        if (v < lo || v >= hi) return false;
+    }
+    return true;
+}
+}  // namespace
+
+// 等价类数由 byte_class_ 推出（最大类号 + 1），不单独保存
+void AhoCorasick::write_sections(IndexWriter& writer) const {
+    writer.add(kTagAcMeta, &max_len_, sizeof(max_len_), sizeof(max_len_));
+    writer.add(kTagAcClass, byte_class_, sizeof(byte_class_));
+    writer.add_array(kTagAcNext, next_);
+    writer.add_array(kTagAcDepth, depth_);
+    writer.add_array(kTagAcTerm, term_);
+    writer.add_array(kTagAcReport, report_);
+    writer.add_array(kTagAcOutLink, out_link_);
+    writer.add_array(kTagAcUniqueLen, unique_len_);
+    writer.add_array(kTagAcPatternIds, pattern_ids_);
+}
+
+bool AhoCorasick::read_sections(const IndexFile& file, std::shared_ptr<const void> owner) {
+    ConstSpan<size_t> meta;
+    std::string_view classes;
+    AhoCorasick ac;
+    if (!file.array(kTagAcMeta, meta) || meta.size() != 1 || !file.bytes(kTagAcClass, classes) ||
+        classes.size() != sizeof(ac.byte_class_) || !file.array(kTagAcNext, ac.next_) ||
+        !file.array(kTagAcDepth, ac.depth_) || !file.array(kTagAcTerm, ac.term_) ||
+        !file.array(kTagAcReport, ac.report_) || !file.array(kTagAcOutLink, ac.out_link_) ||
+        !file.array(kTagAcUniqueLen, ac.unique_len_) || !file.array(kTagAcPatternIds, ac.pattern_ids_)) {
+        return false;
+    }
+
+    ac.max_len_ = meta[0];
+    std::memcpy(ac.byte_class_, classes.data(), sizeof(ac.byte_class_));
+    ac.num_classes_ = *std::max_element(ac.byte_class_, ac.byte_class_ + 256) + 1;
+
+    // 扫描时不做越界检查，因此加载时核对各表的大小与取值范围，损坏的文件直接拒绝
+    const size_t states = ac.depth_.size();
+    const int state_limit = static_cast<int>(states);
+    const int unique_limit = static_cast<int>(ac.unique_len_.size());
+    if (states == 0 || states > static_cast<size_t>(INT32_MAX) ||
+        ac.next_.size() != states * static_cast<size_t>(ac.num_classes_) || ac.term_.size() != states ||
+        ac.report_.size() != states || ac.out_link_.size() != states || !all_in_range(ac.next_, 0, state_limit) ||
+        !all_in_range(ac.term_, -1, unique_limit) || !all_in_range(ac.report_, -1, state_limit) ||
+        !all_in_range(ac.out_link_, -1, state_limit) || !all_in_range(ac.pattern_ids_, -1, unique_limit) ||
+        !all_in_range(ac.depth_, 0, state_limit) ||
+        !all_in_range(ac.unique_len_, 1, static_cast<int>(std::min<size_t>(ac.max_len_, INT32_MAX - 1)) + 1)) {
+        return false;
+    }
+    // 输出链只能指向带输出的状态（否则扫描时 term_[o] 为 -1），且沿链深度严格递减（不会成环）
+    for (size_t st = 0; st < states; ++st) {
+        int r = ac.report_[st];
+        int o = ac.out_link_[st];
+        if (r != -1 && (ac.term_[r] == -1 || (static_cast<size_t>(r) != st && ac.depth_[r] >= ac.depth_[st]))) {
+            return false;
+        }
+        if (o != -1 && (ac.term_[o] == -1 || ac.depth_[o] >= ac.depth_[st])) return false;
+    }
+
+    ac.storage_ = std::move(owner);
+    *this = std::move(ac);
+    return true;
+}
+
+bool AhoCorasick::save(const std::string& path) const {
+    IndexWriter writer(kAutomatonIndexKind);
+    write_sections(writer);
+    return writer.write(path);
+}
+
+bool AhoCorasick::load(const std::string& path) {
+    auto file = std::make_shared<IndexFile>();
+    if (!file->open(path, kAutomatonIndexKind, true)) return false;
+    const IndexFile& ref = *file;
+    return read_sections(ref, std::move(file));
+}
+
+// ---------------- Teddy 多字面量匹配 ----------------
+
+namespace {
+#if defined(__x86_64__) || defined(__i386__)
+bool detect_ssse3() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+}
+
+const bool g_has_ssse3 = detect_ssse3();
+
+// 从 start 起按 16 字节块扫描起点，块内所有起点都需在 limit 之前（limit 已保证前缀的 K 个字节不越界）。
+// 有候选时把块内各起点的桶位掩码交给 on_block(块起点, 候选位, 桶掩码)，其返回 false 时返回 SIZE_MAX；
+// 否则返回向量块覆盖不到的第一个起点
+template <size_t K, typename OnBlock>
+__attribute__((target("ssse3"))) size_t teddy_loop_ssse3(const char* text, size_t start, size_t limit,
+                                                         const std::uint8_t (*lo)[16], const std::uint8_t (*hi)[16],
+                                                         const std::uint8_t& active, OnBlock& on_block) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i lo_table[K];
+    __m128i hi_table[K];
+    for (size_t j = 0; j < K; ++j) {
+        lo_table[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo[j]));
+        hi_table[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi[j]));
+    }
+
+    size_t p = start;
+    for (; p + 16 <= limit; p += 16) {
+        __m128i res = _mm_set1_epi8(static_cast<char>(active));
+        for (size_t j = 0; j < K; ++j) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + p + j));
+            const __m128i low = _mm_shuffle_epi8(lo_table[j], _mm_and_si128(block, nibble));
+            const __m128i high = _mm_shuffle_epi8(hi_table[j], _mm_and_si128(_mm_srli_epi16(block, 4), nibble));
+            res = _mm_and_si128(res, _mm_and_si128(low, high));
+        }
+        const unsigned zero = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(res, _mm_setzero_si128())));
+        const unsigned mask = zero ^ 0xFFFFu;
+        if (mask != 0) {
+            alignas(16) std::uint8_t buckets[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(buckets), res);
+            if (!on_block(p, mask, buckets)) return SIZE_MAX;
+        }
+    }
+    return p;
+}
+
+// 同上，32 字节块；PSHUFB 在两个 128 位通道内分别查表，两个通道放同一份表
+template <size_t K, typename OnBlock>
+__attribute__((target("avx2"))) size_t teddy_loop_avx2(const char* text, size_t start, size_t limit,
+                                                       const std::uint8_t (*lo)[16], const std::uint8_t (*hi)[16],
+                                                       const std::uint8_t& active, OnBlock& on_block) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i lo_table[K];
+    __m256i hi_table[K];
+    for (size_t j = 0; j < K; ++j) {
+        lo_table[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lo[j])));
+        hi_table[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi[j])));
+    }
+
+    size_t p = start;
+    for (; p + 32 <= limit; p += 32) {
+        __m256i res = _mm256_set1_epi8(static_cast<char>(active));
+        for (size_t j = 0; j < K; ++j) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + p + j));
+            const __m256i low = _mm256_shuffle_epi8(lo_table[j], _mm256_and_si256(block, nibble));
+            const __m256i high =
+                _mm256_shuffle_epi8(hi_table[j], _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+            res = _mm256_and_si256(res, _mm256_and_si256(low, high));
+        }
+        const unsigned zero = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(res, _mm256_setzero_si256())));
+        const unsigned mask = ~zero;
+        if (mask != 0) {
+            alignas(32) std::uint8_t buckets[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(buckets), res);
+            if (!on_block(p, mask, buckets)) return SIZE_MAX;
+        }
+    }
+    return p;
+}
+
+template <size_t K, typename OnBlock>
+size_t teddy_loop(const char* text, size_t start, size_t limit, const std::uint8_t (*lo)[16],
+                  const std::uint8_t (*hi)[16], const std::uint8_t& active, OnBlock& on_block) {
+    if (g_simd_level == SimdLevel::AVX2) return teddy_loop_avx2<K>(text, start, limit, lo, hi, active, on_block);
+    if (g_has_ssse3) return teddy_loop_ssse3<K>(text, start, limit, lo, hi, active, on_block);
+    return start;
+}
+#endif
+}  // namespace
+
+TeddyMatcher::TeddyMatcher(const std::vector<StrView>& literals) { build(literals); }
+
+void TeddyMatcher::build(const std::vector<StrView>& literals) {
+    *this = TeddyMatcher();
+    literals_.assign(literals.begin(), literals.end());
+    bucket_begin_.assign(kBuckets + 1, 0);
+
+    std::vector<int> ids;
+    size_t shortest = SIZE_MAX;
+    for (size_t id = 0; id < literals_.size(); ++id) {
+        const size_t len = literals_[id].size();
+        lengths_.push_back(static_cast<int>(len));
+        if (len == 0) continue;
+        ids.push_back(static_cast<int>(id));
+        shortest = std::min(shortest, len);
+        max_len_ = std::max(max_len_, len);
+    }
+    if (ids.empty()) return;
+    prefix_ = std::min(kMaxPrefix, shortest);
+
+    // 按前缀排序后连续分组：同一桶内的前缀相近，半字节表的误报少
+    std::sort(ids.begin(), ids.end(), [&](int a, int b) {
+        const int order = StrView(literals_[a]).substr(0, prefix_).compare(StrView(literals_[b]).substr(0, prefix_));
+        return order != 0 ? order < 0 : a < b;
+    });
+    bucket_ids_ = ids;
+    const size_t count = ids.size();
+    for (size_t b = 0; b <= kBuckets; ++b) bucket_begin_[b] = static_cast<int>((b * count + kBuckets - 1) / kBuckets);
+
+    for (size_t b = 0; b < kBuckets; ++b) {
+        for (int k = bucket_begin_[b]; k < bucket_begin_[b + 1]; ++k) {
+            const std::string& literal = literals_[bucket_ids_[k]];
+            for (size_t j = 0; j < prefix_; ++j) {
+                const unsigned char c = static_cast<unsigned char>(literal[j]);
+                lo_[j][c & 0x0f] |= static_cast<std::uint8_t>(1u << b);
+                hi_[j][c >> 4] |= static_cast<std::uint8_t>(1u << b);
+            }
+        }
+    }
+    for (size_t j = 0; j < prefix_; ++j) {
+        for (int c = 0; c < 256; ++c) byte_mask_[j][c] = lo_[j][c & 0x0f] & hi_[j][c >> 4];
+    }
+}
+
+// 逐个比较 buckets 中各桶的字面量；返回 false 表示 visit 要求停止
+template <typename Visit>
+bool TeddyMatcher::verify(StrView text, size_t pos, unsigned buckets, Visit& visit) const {
+    while (buckets != 0) {
+        const unsigned b = static_cast<unsigned>(__builtin_ctz(buckets));
+        for (int k = bucket_begin_[b]; k < bucket_begin_[b + 1]; ++k) {
+            const int id = bucket_ids_[k];
+            const size_t len = static_cast<size_t>(lengths_[id]);
+            if (pos + len <= text.size() && std::memcmp(text.data() + pos, literals_[id].data(), len) == 0 &&
+                !visit(id, pos)) {
+                return false;
+            }
+        }
+        buckets &= buckets - 1;
+    }
+    return true;
+}
+
+template <typename Visit>
+void TeddyMatcher::scan(StrView text, size_t start, size_t end, const std::uint8_t& active, Visit& visit) const {
+    const size_t n = text.size();
+    if (prefix_ == 0 || n < prefix_) return;
+    // 起点之后不足 prefix_ 个字节的位置不可能命中
+    end = std::min(end, n + 1 - prefix_);
+    if (start >= end) return;
+
+    size_t p = start;
+#if defined(__x86_64__) || defined(__i386__)
+    auto on_block = [&](size_t block, unsigned mask, const std::uint8_t* buckets) {
+        while (mask != 0) {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (!verify(text, block + bit, buckets[bit] & active, visit)) return false;
+            mask &= mask - 1;
+        }
+        return true;
+    };
+    switch (prefix_) {
+    case 1:
+        p = teddy_loop<1>(text.data(), start, end, lo_, hi_, active, on_block);
+        break;
+    case 2:
+        p = teddy_loop<2>(text.data(), start, end, lo_, hi_, active, on_block);
+        break;
+    default:
+        p = teddy_loop<3>(text.data(), start, end, lo_, hi_, active, on_block);
+        break;
+    }
+    if (p == SIZE_MAX) return;
+#endif
+
+    // 标量实现与向量块之后的尾部：按整字节查合并后的表
+    for (; p < end; ++p) {
+        unsigned buckets = active & byte_mask_[0][static_cast<unsigned char>(text[p])];
+        for (size_t j = 1; j < prefix_ && buckets != 0; ++j) {
+            buckets &= byte_mask_[j][static_cast<unsigned char>(text[p + j])];
+        }
+        if (buckets != 0 && !verify(text, p, buckets, visit)) return;
+    }
+}
+
+std::vector<std::vector<MatchPos>> TeddyMatcher::match(StrView text) const {
+    std::vector<std::vector<MatchPos>> results(pattern_count());
+    const std::uint8_t active = 0xFF;
+    auto visit = [&](int id, size_t pos) {
+        results[id].push_back(static_cast<MatchPos>(pos));
+        return true;
+    };
+    scan(text, 0, text.size(), active, visit);
+    return results;
+}
+
+std::vector<int> TeddyMatcher::find_present(StrView text, int num_threads) const {
+    std::vector<int> present;
+    const size_t targets = bucket_ids_.size();
+    const size_t n = text.size();
+    if (targets == 0 || n < prefix_) return present;
+
+    std::vector<std::uint8_t> bucket_of(pattern_count(), 0);
+    for (size_t b = 0; b < kBuckets; ++b) {
+        for (int k = bucket_begin_[b]; k < bucket_begin_[b + 1]; ++k) {
+            bucket_of[bucket_ids_[k]] = static_cast<std::uint8_t>(b);
+        }
+    }
+
+    ChunkPlan plan = plan_chunks(n, max_len_, num_threads);
+    std::unique_ptr<std::atomic<unsigned char>[]> seen(new std::atomic<unsigned char>[pattern_count()]);
+    for (size_t id = 0; id < pattern_count(); ++id) seen[id].store(0, std::memory_order_relaxed);
+    std::atomic<size_t> found{0};
+
+    auto bucket_done = [&](size_t b) {
+        for (int k = bucket_begin_[b]; k < bucket_begin_[b + 1]; ++k) {
+            if (!seen[bucket_ids_[k]].load(std::memory_order_relaxed)) return false;
+        }
+        return true;
+    };
+
+    parallel_for_dynamic(plan.count, plan.workers, [&](size_t chunk_id) {
+        if (found.load(std::memory_order_relaxed) == targets) return;
+        const size_t start = chunk_id * plan.chunk;
+        const size_t end = std::min(start + plan.chunk, n);
+
+        // 其他块已经找齐的桶不再校验
+        std::uint8_t active = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            if (bucket_begin_[b] < bucket_begin_[b + 1] && !bucket_done(b)) {
+                active |= static_cast<std::uint8_t>(1u << b);
+            }
+        }
+        auto visit = [&](int id, size_t) {
+            if (seen[id].load(std::memory_order_relaxed)) return true;
+            if (seen[id].exchange(1, std::memory_order_relaxed)) return true;
+            if (found.fetch_add(1, std::memory_order_relaxed) + 1 == targets) return false;
+            if (bucket_done(bucket_of[id])) active &= static_cast<std::uint8_t>(~(1u << bucket_of[id]));
+            return true;
+        };
+        scan(text, start, end, active, visit);
+    });
+
+    for (size_t id = 0; id < pattern_count(); ++id) {
+        if (seen[id].load(std::memory_order_relaxed)) present.push_back(static_cast<int>(id));
+    }
+    return present;
+}
@@ -0,0 +1,252 @@
+#include "result_writer.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace {
+constexpr std::uint32_t kResultKind = index_tag("MPOS");
+constexpr std::uint32_t kTagCounts = index_tag("LCNT");
+constexpr std::uint32_t kTagOffsets = index_tag("LOFF");
+constexpr std::uint32_t kTagData = index_tag("LDAT");
+
+// 每段约含的位置数（每个列表另计 1），小列表合并进同一段，大列表切成多段
+constexpr size_t kPieceWeight = 1 << 16;
+// 一个 int64 的十进制最多 20 个字符，加分隔符
+constexpr size_t kMaxFieldChars = 21;
+
+using Lists = std::vector<std::vector<MatchPos>>;
+
+// 扁平化后的一段：从 lists[first] 的下标 begin 到 lists[last] 的下标 end（不含）
+struct Piece {
+    size_t first;
+    size_t begin;
+    size_t last;
+    size_t end;
+};
+
+// 按权重切段。每次至少取一个位置，保证段不会恰好结束在某个非空列表的开头，列表头（计数）只出现在一段中
+std::vector<Piece> split_pieces(const Lists& lists) {
+    std::vector<Piece> pieces;
+    Piece cur{0, 0, 0, 0};
+    size_t weight = 0;
+    for (size_t l = 0; l < lists.size(); ++l) {
+        const size_t size = lists[l].size();
+        size_t b = 0;
+        weight += 1;
+        for (;;) {
+            size_t room = std::max<size_t>(1, kPieceWeight > weight ? kPieceWeight - weight : 0);
+            size_t take = std::min(size - b, room);
+            b += take;
+            weight += take;
+            if (b == size) break;
+            cur.last = l;
+            cur.end = b;
+            pieces.push_back(cur);
+            cur = Piece{l, b, 0, 0};
+            weight = 0;
+        }
+        if (weight >= kPieceWeight) {
+            cur.last = l;
+            cur.end = size;
+            pieces.push_back(cur);
+            cur = Piece{l + 1, 0, 0, 0};
+            weight = 0;
+        }
+    }
+    if (weight > 0) {
+        cur.last = lists.size() - 1;
+        cur.end = lists.back().size();
+        pieces.push_back(cur);
+    }
+    return pieces;
+}
+
+// 对段内每个列表片段调用 fn(list, begin, end)
+template <typename Fn> void for_each_span(const Lists& lists, const Piece& piece, Fn fn) {
+    for (size_t l = piece.first; l <= piece.last; ++l) {
+        size_t b = (l == piece.first) ? piece.begin : 0;
+        size_t e = (l == piece.last) ? piece.end : lists[l].size();
+        fn(l, b, e);
+    }
+}
+
+// 只增不减的格式化缓冲区，各轮之间复用，避免反复分配和清零
+struct Buffer {
+    std::unique_ptr<char[]> data;
+    size_t capacity{0};
+    size_t size{0};
+
+    char* reserve(size_t bytes) {
+        if (bytes > capacity) {
+            data.reset(new char[bytes]);
+            capacity = bytes;
+        }
+        size = 0;
+        return data.get();
+    }
+};
+
+void format_text(const Lists& lists, const Piece& piece, Buffer& buffer) {
+    size_t bound = 0;
+    for_each_span(lists, piece, [&](size_t, size_t b, size_t e) { bound += (e - b + 2) * kMaxFieldChars; });
+
+    char* out = buffer.reserve(bound);
+    char* const limit = out + bound;
+    for_each_span(lists, piece, [&](size_t l, size_t b, size_t e) {
+        const std::vector<MatchPos>& list = lists[l];
+        if (b == 0) out = std::to_chars(out, limit, list.size()).ptr;
+        for (size_t i = b; i < e; ++i) {
+            *out++ = ' ';
+            out = std::to_chars(out, limit, list[i]).ptr;
+        }
+        if (e == list.size()) *out++ = '\n';
+    });
+    buffer.size = static_cast<size_t>(out - buffer.data.get());
+}
+
+bool write_text(const std::string& path, const Lists& lists, int num_threads) {
+    std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        std::cout << "Fail to open file: " << path << std::endl;
+        return false;
+    }
+
+    // 每轮格式化 2 * 并发度个段，再按顺序写出；缓冲区按槽位跨轮复用
+    const std::vector<Piece> pieces = split_pieces(lists);
+    const int workers = std::max(num_threads, 1);
+    const size_t wave = static_cast<size_t>(workers) * 2;
+    std::vector<Buffer> buffers(std::min(wave, pieces.size()));
+    for (size_t first = 0; first < pieces.size(); first += wave) {
+        size_t count = std::min(wave, pieces.size() - first);
+        parallel_for_dynamic(count, workers, [&](size_t k) { format_text(lists, pieces[first + k], buffers[k]); });
+        for (size_t k = 0; k < count; ++k) {
+            fout.write(buffers[k].data.get(), static_cast<std::streamsize>(buffers[k].size));
+        }
+    }
+    return static_cast<bool>(fout);
+}
+
+size_t varint_size(std::uint64_t v) {
+    size_t bytes = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+char* put_varint(char* out, std::uint64_t v) {
+    while (v >= 0x80) {
+        *out++ = static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    *out++ = static_cast<char>(v);
+    return out;
+}
+
+// 列表内第一个位置相对 0 差分，其余相对前一个位置
+std::uint64_t delta_at(const std::vector<MatchPos>& list, size_t i) {
+    return static_cast<std::uint64_t>(list[i]) - (i == 0 ? 0 : static_cast<std::uint64_t>(list[i - 1]));
+}
+
+// 编码结果就是各段按顺序首尾相接：先并行算出每段的字节数，前缀和得到各段起点，再并行编码到最终位置
+bool write_binary(const std::string& path, const Lists& lists, int num_threads) {
+    const std::vector<Piece> pieces = split_pieces(lists);
+    const int workers = std::max(num_threads, 1);
+
+    std::vector<size_t> piece_offsets(pieces.size() + 1, 0);
+    parallel_for_dynamic(pieces.size(), workers, [&](size_t p) {
+        size_t bytes = 0;
+        for_each_span(lists, pieces[p], [&](size_t l, size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) bytes += varint_size(delta_at(lists[l], i));
+        });
+        piece_offsets[p + 1] = bytes;
+    });
+    for (size_t p = 0; p < pieces.size(); ++p) piece_offsets[p + 1] += piece_offsets[p];
+
+    // 每个列表的开头只落在一个段内，由该段写入其偏移
+    std::vector<char> data(piece_offsets.back());
+    std::vector<std::uint64_t> offsets(lists.size() + 1, data.size());
+    parallel_for_dynamic(pieces.size(), workers, [&](size_t p) {
+        char* out = data.data() + piece_offsets[p];
+        for_each_span(lists, pieces[p], [&](size_t l, size_t b, size_t e) {
+            if (b == 0) offsets[l] = static_cast<std::uint64_t>(out - data.data());
+            for (size_t i = b; i < e; ++i) out = put_varint(out, delta_at(lists[l], i));
+        });
+    });
+
+    std::vector<std::uint64_t> counts(lists.size());
+    for (size_t l = 0; l < lists.size(); ++l) counts[l] = lists[l].size();
+
+    IndexWriter writer(kResultKind);
+    writer.add_array(kTagCounts, ConstSpan<std::uint64_t>(counts));
+    writer.add_array(kTagOffsets, ConstSpan<std::uint64_t>(offsets));
+    writer.add(kTagData, data.data(), data.size());
+    return writer.write(path);
+}
+}  // namespace
+
+bool write_position_lists(const std::string& path, const Lists& lists, int num_threads, ResultFormat format) {
+    if (format == ResultFormat::Binary) return write_binary(path, lists, num_threads);
+    return write_text(path, lists, num_threads);
+}
+
+bool write_text_file(const std::string& path, std::string_view data) {
+    std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        std::cout << "Fail to open file: " << path << std::endl;
+        return false;
+    }
+    fout.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(fout);
+}
+
+bool PositionListFile::open(const std::string& path) {
+    *this = PositionListFile();
+
+    IndexFile file;
+    ConstSpan<std::uint64_t> counts, offsets;
+    std::string_view data;
+    if (!file.open(path, kResultKind) || !file.array(kTagCounts, counts) || !file.array(kTagOffsets, offsets) ||
+        !file.bytes(kTagData, data) || offsets.size() != counts.size() + 1 || offsets[0] != 0 ||
+        offsets[counts.size()] != data.size()) {
+        return false;
+    }
+    for (size_t l = 0; l < counts.size(); ++l) {
+        if (offsets[l + 1] < offsets[l]) return false;
+    }
+
+    file_ = std::move(file);
+    counts_ = counts;
+    offsets_ = offsets;
+    data_ = data;
+    return true;
+}
+
+bool PositionListFile::positions(size_t list, std::vector<MatchPos>& out) const {
+    out.clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data_.data()) + offsets_[list];
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(data_.data()) + offsets_[list + 1];
+    const size_t n = count(list);
+    // 每个位置至少占 1 字节，计数大于字节数说明数据损坏，避免按损坏的计数分配
+    if (n > static_cast<size_t>(end - p)) return false;
+    out.reserve(n);
+
+    std::uint64_t pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::uint64_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p == end || shift > 63) return false;
+            unsigned char byte = *p++;
+            delta |= std::uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        pos += delta;
+        out.push_back(static_cast<MatchPos>(pos));
+    }
+    return p == end;
+}
@@ -0,0 +1,179 @@
+#include "signature_set.hpp"
+#include "tuning.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+namespace {
+constexpr std::uint32_t kSignatureIndexKind = index_tag("SIGS");
+constexpr std::uint32_t kTagFingerprint = index_tag("FPRT");
+constexpr std::uint32_t kTagNames = index_tag("NAMS");
+constexpr std::uint32_t kTagNameOffsets = index_tag("NAMO");
+constexpr std::uint32_t kTagSignatures = index_tag("SIGB");
+constexpr std::uint32_t kTagSignatureOffsets = index_tag("SIGO");
+
+std::string signature_index_path(const std::string& dir) {
+    std::string path = dir;
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+    return path + ".idx";
+}
+
+// 排序后的文件列表及各文件大小、修改时间的散列，任一特征文件增删改都会改变
+std::uint64_t directory_fingerprint(const std::vector<std::string>& sorted_paths) {
+    std::uint64_t h = index_checksum(nullptr, 0);
+    for (const std::string& path : sorted_paths) {
+        std::uint64_t stat[2] = {0, 0};
+        std::int64_t mtime = 0;
+        file_stat(path, stat[0], mtime);
+        stat[1] = static_cast<std::uint64_t>(mtime);
+        h = h * 31 + index_checksum(path.data(), path.size());
+        h = h * 31 + index_checksum(stat, sizeof(stat));
+    }
+    return h;
+}
+
+// 拼接字符串，offsets 共 count+1 项
+void pack_strings(const std::vector<std::string>& items, std::string& bytes, std::vector<std::uint64_t>& offsets) {
+    offsets.assign(1, 0);
+    for (const std::string& item : items) {
+        bytes += item;
+        offsets.push_back(bytes.size());
+    }
+}
+
+bool unpack_strings(std::string_view bytes, ConstSpan<std::uint64_t> offsets, std::vector<std::string>& items) {
+    if (offsets.empty() || offsets[0] != 0 || offsets[offsets.size() - 1] != bytes.size()) return false;
+    items.clear();
+    for (size_t k = 1; k < offsets.size(); ++k) {
+        if (offsets[k] < offsets[k - 1]) return false;
+        items.emplace_back(bytes.substr(offsets[k - 1], offsets[k] - offsets[k - 1]));
+    }
+    return true;
+}
+
+std::vector<std::string> sorted_files(const std::string& dir) {
+    std::vector<std::string> paths = list_all_files(dir);
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+SignatureSet compile_files(const std::vector<std::string>& paths) {
+    SignatureSet set;
+    for (const std::string& path : paths) {
+        FileView fv = read_file_view(path);
+        if (fv.view.empty()) continue;  // 读失败则跳过
+        set.add(std::filesystem::path(path).filename().string(), fv.view);
+    }
+    set.compile();
+    return set;
+}
+}  // namespace
+
+SignatureSet SignatureSet::load_directory(const std::string& dir) {
+    std::vector<std::string> paths = sorted_files(dir);
+
+    SignatureSet set;
+    if (set.load(signature_index_path(dir), directory_fingerprint(paths))) return set;
+    return compile_files(paths);
+}
+
+bool SignatureSet::save_index(const std::string& dir) {
+    std::vector<std::string> paths = sorted_files(dir);
+    return compile_files(paths).save(signature_index_path(dir), directory_fingerprint(paths));
+}
+
+bool SignatureSet::save(const std::string& path, std::uint64_t fingerprint) const {
+    // 特征较少时 compile 不构建自动机，保存时补建，使索引与当时的调优配置无关
+    AhoCorasick built;
+    const AhoCorasick* automaton = &automaton_;
+    if (automaton_.pattern_count() != signatures_.size()) {
+        built = AhoCorasick(signatures_);
+        automaton = &built;
+    }
+
+    std::string names, signatures;
+    std::vector<std::uint64_t> name_offsets, signature_offsets;
+    pack_strings(names_, names, name_offsets);
+    pack_strings(signatures_, signatures, signature_offsets);
+
+    IndexWriter writer(kSignatureIndexKind);
+    writer.add(kTagFingerprint, &fingerprint, sizeof(fingerprint), sizeof(fingerprint));
+    writer.add(kTagNames, names.data(), names.size());
+    writer.add_array(kTagNameOffsets, ConstSpan<std::uint64_t>(name_offsets));
+    writer.add(kTagSignatures, signatures.data(), signatures.size());
+    writer.add_array(kTagSignatureOffsets, ConstSpan<std::uint64_t>(signature_offsets));
+    automaton->write_sections(writer);
+    return writer.write(path);
+}
+
+bool SignatureSet::load(const std::string& path, std::uint64_t fingerprint) {
+    // 特征集合很小，打开时连同数据校验和一起检查
+    auto file = std::make_shared<IndexFile>();
+    if (!file->open(path, kSignatureIndexKind, true)) return false;
+
+    ConstSpan<std::uint64_t> stored, name_offsets, signature_offsets;
+    std::string_view names, signatures;
+    if (!file->array(kTagFingerprint, stored) || stored.size() != 1 || stored[0] != fingerprint ||
+        !file->bytes(kTagNames, names) || !file->array(kTagNameOffsets, name_offsets) ||
+        !file->bytes(kTagSignatures, signatures) || !file->array(kTagSignatureOffsets, signature_offsets)) {
+        return false;
+    }
+
+    SignatureSet set;
+    if (!unpack_strings(names, name_offsets, set.names_) ||
+        !unpack_strings(signatures, signature_offsets, set.signatures_) ||
+        set.names_.size() != set.signatures_.size()) {
+        return false;
+    }
+    const IndexFile& ref = *file;
+    if (!set.automaton_.read_sections(ref, std::move(file)) ||
+        set.automaton_.pattern_count() != set.signatures_.size()) {
+        return false;
+    }
+    set.compile_small();
+
+    *this = std::move(set);
+    return true;
+}
+
+void SignatureSet::add(std::string name, std::string_view bytes) {
+    names_.push_back(std::move(name));
+    signatures_.emplace_back(bytes);
+}
+
+bool SignatureSet::compile_small() {
+    teddy_ = TeddyMatcher();
+    compiled_.clear();
+    if (prefer_teddy(signatures_.size())) {
+        std::vector<std::string_view> views(signatures_.begin(), signatures_.end());
+        teddy_.build(views);
+        return true;
+    }
+    if (prefer_multi_pattern(signatures_.size())) return false;
+    for (const std::string& signature : signatures_) compiled_.emplace_back(signature, MatchAlgo::Auto);
+    return true;
+}
+
+void SignatureSet::compile() {
+    if (compile_small()) {
+        automaton_ = AhoCorasick();
+        return;
+    }
+    std::vector<std::string_view> views(signatures_.begin(), signatures_.end());
+    automaton_.build(views);
+}
+
+std::vector<int> SignatureSet::scan(std::string_view buffer, int num_threads) const {
+    // 小文件不值得并行，线程数按缓冲区大小收缩
+    int threads = choose_threads(buffer.size(), num_threads);
+    if (teddy_.pattern_count() != 0) return teddy_.find_present(buffer, threads);
+    if (compiled_.empty()) return automaton_.find_present(buffer, threads);
+
+    std::vector<int> present;
+    for (size_t id = 0; id < compiled_.size(); ++id) {
+        if (binary_match_exists(buffer, compiled_[id], threads)) present.push_back(static_cast<int>(id));
+    }
+    return present;
+}
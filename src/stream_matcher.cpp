@@ -0,0 +1,137 @@
+#include "stream_matcher.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <utility>
+#ifdef __unix__
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+using StrView = std::string_view;
+
+StreamMatcher::StreamMatcher(CompiledPattern pattern) : pattern_(std::move(pattern)) {
+    size_t keep = pattern_.size() > 0 ? pattern_.size() - 1 : 0;
+    carry_.reserve(keep);
+    boundary_.reserve(2 * keep);
+}
+
+StreamMatcher::StreamMatcher(StrView pattern, MatchAlgo algo) : StreamMatcher(CompiledPattern(pattern, algo)) {}
+
+void StreamMatcher::feed(StrView chunk, std::vector<MatchPos>& positions) {
+    const size_t m = pattern_.size();
+    if (m == 0 || chunk.empty()) {
+        consumed_ += static_cast<MatchPos>(chunk.size());
+        return;
+    }
+    const size_t keep = m - 1;
+
+    // 跨段命中：起点落在上一段末尾 m-1 字节内，只需扫描 carry_ + 本段开头 m-1 字节
+    if (!carry_.empty()) {
+        boundary_.assign(carry_);
+        boundary_.append(chunk.substr(0, keep));
+
+        // 起点在本段内的命中交给下面的整段扫描：命中升序到达，遇到第一个即停止
+        pattern_.for_each(boundary_, consumed_ - static_cast<MatchPos>(carry_.size()), [&](MatchPos pos) {
+            if (pos >= consumed_) return false;
+            positions.push_back(pos);
+            return true;
+        });
+    }
+
+    pattern_.match(chunk, consumed_, positions);
+
+    if (chunk.size() >= keep) {
+        carry_.assign(chunk.substr(chunk.size() - keep));
+    } else {
+        carry_.append(chunk);
+        if (carry_.size() > keep) carry_.erase(0, carry_.size() - keep);
+    }
+    consumed_ += static_cast<MatchPos>(chunk.size());
+}
+
+void StreamMatcher::reset() {
+    carry_.clear();
+    consumed_ = 0;
+}
+
+AhoCorasickStream::AhoCorasickStream(const AhoCorasick& automaton) : automaton_(&automaton) {}
+
+void AhoCorasickStream::feed(StrView chunk, std::vector<std::vector<MatchPos>>& results) {
+    if (results.size() < automaton_->pattern_count()) results.resize(automaton_->pattern_count());
+    state_ = automaton_->scan_stream(state_, chunk, consumed_, results);
+    consumed_ += static_cast<MatchPos>(chunk.size());
+}
+
+void AhoCorasickStream::reset() {
+    state_ = 0;
+    consumed_ = 0;
+}
+
+namespace {
+// 用固定缓冲区反复读取，read 返回本次读到的字节数，0 表示结束
+template <typename Read, typename Feed> void pump(size_t buffer_size, Read read, Feed feed) {
+    std::vector<char> buffer(std::max<size_t>(buffer_size, 1));
+    for (;;) {
+        size_t got = read(buffer.data(), buffer.size());
+        if (got == 0) break;
+        feed(StrView(buffer.data(), got));
+    }
+}
+
+size_t read_istream(std::istream& in, char* data, size_t size) {
+    in.read(data, static_cast<std::streamsize>(size));
+    return static_cast<size_t>(in.gcount());
+}
+
+size_t read_fd(int fd, char* data, size_t size) {
+#ifdef __unix__
+    for (;;) {
+        ssize_t got = ::read(fd, data, size);
+        if (got >= 0) return static_cast<size_t>(got);
+        if (errno != EINTR) return 0;  // 读错误按流结束处理
+    }
+#else
+    (void)fd;
+    (void)data;
+    (void)size;
+    return 0;
+#endif
+}
+}  // namespace
+
+std::vector<MatchPos> match_stream(std::istream& in, const CompiledPattern& pattern, size_t buffer_size) {
+    std::vector<MatchPos> positions;
+    StreamMatcher stream(pattern);
+    pump(
+        buffer_size, [&](char* data, size_t size) { return read_istream(in, data, size); },
+        [&](StrView chunk) { stream.feed(chunk, positions); });
+    return positions;
+}
+
+std::vector<MatchPos> match_stream(int fd, const CompiledPattern& pattern, size_t buffer_size) {
+    std::vector<MatchPos> positions;
+    StreamMatcher stream(pattern);
+    pump(
+        buffer_size, [&](char* data, size_t size) { return read_fd(fd, data, size); },
+        [&](StrView chunk) { stream.feed(chunk, positions); });
+    return positions;
+}
+
+std::vector<std::vector<MatchPos>> match_stream(std::istream& in, const AhoCorasick& automaton, size_t buffer_size) {
+    std::vector<std::vector<MatchPos>> results(automaton.pattern_count());
+    AhoCorasickStream stream(automaton);
+    pump(
+        buffer_size, [&](char* data, size_t size) { return read_istream(in, data, size); },
+        [&](StrView chunk) { stream.feed(chunk, results); });
+    return results;
+}
+
+std::vector<std::vector<MatchPos>> match_stream(int fd, const AhoCorasick& automaton, size_t buffer_size) {
+    std::vector<std::vector<MatchPos>> results(automaton.pattern_count());
+    AhoCorasickStream stream(automaton);
+    pump(
+        buffer_size, [&](char* data, size_t size) { return read_fd(fd, data, size); },
+        [&](StrView chunk) { stream.feed(chunk, results); });
+    return results;
+}
@@ -0,0 +1,237 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace {
+std::atomic<int> g_configured_threads{0};
+std::atomic<bool> g_pool_created{false};
+
+thread_local ThreadPool* tls_pool = nullptr;
+thread_local int tls_worker_index = -1;
+}  // namespace
+
+bool configure_thread_pool(int num_threads) {
+    if (g_pool_created.load()) return false;
+    g_configured_threads.store(num_threads);
+    return true;
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool([] {
+        g_pool_created.store(true);
+        int num_threads = g_configured_threads.load();
+        if (const char* env = std::getenv("PSM_POOL_THREADS")) {
+            num_threads = std::atoi(env);
+        }
+        if (num_threads <= 0) num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0) num_threads = 1;
+        return num_threads - 1;
+    }());
+    return pool;
+}
+
+ThreadPool::ThreadPool(int num_workers) {
+    if (num_workers < 0) num_workers = 0;
+    // 没有工作线程时仍保留一个队列，任务由等待者执行
+    int num_queues = std::max(1, num_workers);
+    for (int i = 0; i < num_queues; ++i) queues_.push_back(std::make_unique<WorkerQueue>());
+
+    workers_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_.store(true);
+    }
+    sleep_cv_.notify_all();
+    for (auto& th : workers_) th.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = (tls_pool == this && tls_worker_index >= 0)
+                       ? static_cast<size_t>(tls_worker_index)
+                       : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    sleep_cv_.notify_one();
+}
+
+bool ThreadPool::pop_task(std::function<void()>& task) {
+    if (pending_.load() == 0) return false;
+
+    const size_t num_queues = queues_.size();
+    size_t self = (tls_pool == this && tls_worker_index >= 0) ? static_cast<size_t>(tls_worker_index) : 0;
+
+    // 先从自己队列尾部取（最近提交、缓存最热），再从其他队列头部窃取
+    if (tls_pool == this && tls_worker_index >= 0) {
+        WorkerQueue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (size_t k = 0; k < num_queues; ++k) {
+        WorkerQueue& victim = *queues_[(self + k) % num_queues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(int index) {
+    tls_pool = this;
+    tls_worker_index = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (pop_task(task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this]() { return stop_.load() || pending_.load() > 0; });
+        if (stop_.load() && pending_.load() == 0) return;
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool), state_(std::make_shared<State>()) {}
+
+TaskGroup::~TaskGroup() {
+    // 析构前必须等待，否则任务可能引用已销毁的对象
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+bool TaskGroup::run_one(State& state, bool retire) {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.tasks.empty()) {
+            // 与 run 判断是否补充入口在同一把锁下注销，新加入的任务不会既没有入口又没人执行
+            if (retire) --state.entries;
+            return false;
+        }
+        task = std::move(state.tasks.front());
+        state.tasks.pop_front();
+    }
+    std::exception_ptr error;
+    try {
+        task();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (error && !state.error) state.error = error;
+    if (--state.remaining == 0) state.done_cv.notify_all();
+    return true;
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    bool submit = false;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->tasks.push_back(std::move(task));
+        ++state_->remaining;
+        // 每个入口会一直执行到本组队列为空才退出，入口数不超过工作线程数与未开始的任务数；
+        // 没有工作线程时不提交入口，任务全部由等待者执行，线程池里不会积存取不到任务的入口
+        const size_t workers = static_cast<size_t>(pool_.worker_count());
+        if (state_->entries < std::min(workers, state_->tasks.size())) {
+            ++state_->entries;
+            submit = true;
+        }
+    }
+    // 等待者可能正阻塞在 wait 中（任务内部继续向本组提交时），唤醒它帮忙执行
+    state_->done_cv.notify_all();
+    if (submit) {
+        pool_.submit([state = state_]() {
+            while (run_one(*state, true)) {
+            }
+        });
+    }
+}
+
+bool TaskGroup::try_run_one() { return run_one(*state_, false); }
+
+bool TaskGroup::has_pending() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return !state_->tasks.empty();
+}
+
+void TaskGroup::wait() {
+    for (;;) {
+        if (run_one(*state_, false)) continue;
+        // 本组的任务都已开始，等其他线程执行完；有新任务加入时被唤醒继续帮忙
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->done_cv.wait(lock, [this]() { return state_->remaining == 0 || !state_->tasks.empty(); });
+        if (state_->remaining == 0) break;
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        std::swap(error, state_->error);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void parallel_for(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (count == 1) {
+        fn(0);
+        return;
+    }
+
+    TaskGroup group;
+    for (int i = 1; i < count; ++i) {
+        group.run([&fn, i]() { fn(i); });
+    }
+    // 调用线程执行第一个任务，异常需等其他任务结束后再抛出
+    std::exception_ptr error;
+    try {
+        fn(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    group.wait();
+    if (error) std::rethrow_exception(error);
+}
+
+void parallel_for_dynamic(size_t count, int parallelism, const std::function<void(size_t)>& fn,
+                          const std::atomic<size_t>* limit) {
+    if (count == 0) return;
+    if (parallelism <= 0) parallelism = 1;
+    if (static_cast<size_t>(parallelism) > count) parallelism = static_cast<int>(count);
+
+    std::atomic<size_t> cursor{0};
+    parallel_for(parallelism, [&](int) {
+        for (size_t i = cursor.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = cursor.fetch_add(1, std::memory_order_relaxed)) {
+            if (limit && i >= limit->load(std::memory_order_acquire)) break;
+            fn(i);
+        }
+    });
+}
@@ -0,0 +1,282 @@
+#include "tuning.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using StrView = std::string_view;
+
+namespace {
+TuningConfig g_tuning;
+
+const MatchAlgo kConcreteAlgos[] = {MatchAlgo::BF,   MatchAlgo::KMP,     MatchAlgo::Sunday,
+                                    MatchAlgo::RK,   MatchAlgo::BM,      MatchAlgo::SIMD,
+                                    MatchAlgo::ShiftOr, MatchAlgo::BNDM, MatchAlgo::BOM,
+                                    MatchAlgo::TwoWay};
+
+bool parse_algo(const std::string& name, MatchAlgo& algo) {
+    for (MatchAlgo candidate : kConcreteAlgos) {
+        if (name == algo_name(candidate)) {
+            algo = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 校准用的合成文本：按英文字母频率（约千分比）抽样的小写字母与空格，xorshift 生成，结果可复现。
+// 均匀随机文本会让首尾字节过滤的候选过少，低估真实文档上的校验开销
+std::string synthetic_text(size_t n) {
+    static const char kLetters[] = " etaoinshrdlcumwfgypbvkjxqz";
+    static const int kWeights[] = {180, 102, 75, 67, 62, 58, 55, 52, 51, 48, 35, 33, 23,
+                                   23, 20, 19, 18, 17, 16, 15, 12, 8,  6,  2,  2,  1,  1};
+    std::string pool;
+    for (size_t k = 0; k < sizeof(kWeights) / sizeof(kWeights[0]); ++k) pool.append(kWeights[k], kLetters[k]);
+
+    std::string text(n, ' ');
+    unsigned long long state = 88172645463325252ULL;
+    for (size_t i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        text[i] = pool[state % pool.size()];
+    }
+    return text;
+}
+
+// 取两次中较快的一次，降低抖动
+template <typename Fn> double best_of_two(Fn&& fn) {
+    double best = 0.0;
+    for (int r = 0; r < 2; ++r) {
+        double t = time_it(fn);
+        if (r == 0 || t < best) best = t;
+    }
+    return best;
+}
+
+MatchAlgo fastest_algo(StrView text, StrView pattern) {
+    MatchAlgo best_algo = MatchAlgo::SIMD;
+    double best = -1.0;
+    for (MatchAlgo algo : kConcreteAlgos) {
+        CompiledPattern compiled(pattern, algo);
+        double t = best_of_two([&]() { (void)compiled.count(text); });
+        if (best < 0.0 || t < best) {
+            best = t;
+            best_algo = algo;
+        }
+    }
+    return best_algo;
+}
+}  // namespace
+
+const char* algo_name(MatchAlgo algo) {
+    switch (algo) {
+    case MatchAlgo::BF:
+        return "bf";
+    case MatchAlgo::KMP:
+        return "kmp";
+    case MatchAlgo::Sunday:
+        return "sunday";
+    case MatchAlgo::RK:
+        return "rk";
+    case MatchAlgo::BM:
+        return "bm";
+    case MatchAlgo::SIMD:
+        return "simd";
+    case MatchAlgo::ShiftOr:
+        return "shift_or";
+    case MatchAlgo::BNDM:
+        return "bndm";
+    case MatchAlgo::BOM:
+        return "bom";
+    case MatchAlgo::TwoWay:
+        return "two_way";
+    case MatchAlgo::Auto:
+        return "auto";
+    }
+    return "auto";
+}
+
+const TuningConfig& tuning_config() { return g_tuning; }
+
+void set_tuning_config(const TuningConfig& config) { g_tuning = config; }
+
+bool load_tuning_config(const std::string& path) {
+    std::ifstream fin(path);
+    if (!fin.is_open()) return false;
+
+    TuningConfig config = g_tuning;
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+
+        try {
+            if (key == "short_algo") {
+                if (!parse_algo(value, config.short_algo)) return false;
+            } else if (key == "long_algo") {
+                if (!parse_algo(value, config.long_algo)) return false;
+            } else if (key == "low_entropy_algo") {
+                if (!parse_algo(value, config.low_entropy_algo)) return false;
+            } else if (key == "long_pattern") {
+                config.long_pattern = std::stoull(value);
+            } else if (key == "low_entropy_bits") {
+                config.low_entropy_bits = std::stod(value);
+            } else if (key == "min_bytes_per_thread") {
+                config.min_bytes_per_thread = std::max<size_t>(1, std::stoull(value));
+            } else if (key == "multi_pattern_min") {
+                config.multi_pattern_min = std::stoull(value);
+            } else if (key == "teddy_max_patterns") {
+                config.teddy_max_patterns = std::stoull(value);
+            }
+            // 未知键忽略，便于新旧版本共用配置文件
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    g_tuning = config;
+    return true;
+}
+
+bool save_tuning_config(const std::string& path, const TuningConfig& config) {
+    std::ofstream fout(path);
+    if (!fout.is_open()) {
+        std::cout << "Fail to open file: " << path << std::endl;
+        return false;
+    }
+
+    fout << "# parallel string matching tuning, generated by ./myapp --calibrate\n";
+    fout << "short_algo=" << algo_name(config.short_algo) << "\n";
+    fout << "long_algo=" << algo_name(config.long_algo) << "\n";
+    fout << "low_entropy_algo=" << algo_name(config.low_entropy_algo) << "\n";
+    fout << "long_pattern=" << config.long_pattern << "\n";
+    fout << "low_entropy_bits=" << config.low_entropy_bits << "\n";
+    fout << "min_bytes_per_thread=" << config.min_bytes_per_thread << "\n";
+    fout << "multi_pattern_min=" << config.multi_pattern_min << "\n";
+    fout << "teddy_max_patterns=" << config.teddy_max_patterns << "\n";
+    return static_cast<bool>(fout);
+}
+
+std::string default_tuning_path() {
+    const char* env = std::getenv("PSM_TUNING");
+    return (env != nullptr && *env != '\0') ? std::string(env) : std::string("psm_tuning.conf");
+}
+
+TuningConfig calibrate_tuning(int num_threads) {
+    TuningConfig config;
+    num_threads = std::max(num_threads, 1);
+
+    const std::string text = synthetic_text(8 << 20);
+
+    // 1. 各类模式串上最快的内核：模式串取自文本本身，保证至少命中一次
+    const std::string short_pattern = text.substr(text.size() / 3, 8);
+    const std::string long_pattern = text.substr(text.size() / 2, 64);
+    const std::string low_entropy_pattern = std::string(15, 'e') + 't';
+    config.short_algo = fastest_algo(text, short_pattern);
+    config.long_algo = fastest_algo(text, long_pattern);
+    config.low_entropy_algo = fastest_algo(text, low_entropy_pattern);
+
+    // 2. 并行开销：多路并发首次快于单线程时的文本大小，折算为每路至少需要的字节数
+    if (num_threads > 1) {
+        CompiledPattern compiled(short_pattern, config.short_algo);
+        config.min_bytes_per_thread = text.size();
+        for (size_t size = 16 << 10; size <= text.size(); size <<= 1) {
+            StrView part(text.data(), size);
+            double serial = best_of_two([&]() { (void)match_count(part, compiled, 1); });
+            double parallel = best_of_two([&]() { (void)match_count(part, compiled, num_threads); });
+            if (parallel < serial) {
+                config.min_bytes_per_thread = std::max<size_t>(1, size / num_threads);
+                break;
+            }
+        }
+    }
+
+    // 3. 多模式阈值：逐个单模式扫描的总耗时超过一次 Aho-Corasick 扫描时的模式串数量
+    const StrView part(text.data(), 2 << 20);
+    std::vector<std::string> patterns;
+    config.multi_pattern_min = 64;
+    for (size_t count = 1; count <= 64; count <<= 1) {
+        while (patterns.size() < count) {
+            patterns.push_back(text.substr((patterns.size() * 7919 + 4099) % (text.size() - 16), 12));
+        }
+        std::vector<CompiledPattern> singles;
+        for (const auto& p : patterns) singles.emplace_back(p, config.short_algo);
+        AhoCorasick automaton(patterns);
+
+        double single = best_of_two([&]() {
+            for (const auto& compiled : singles) (void)compiled.count(part);
+        });
+        double multi = best_of_two([&]() { (void)automaton.match(part); });
+        if (multi < single) {
+            config.multi_pattern_min = count;
+            break;
+        }
+    }
+
+    // 4. Teddy 上限：只判断出现与否时，Teddy 扫描慢于 Aho-Corasick 之前的最大模式串数量
+    patterns.clear();
+    config.teddy_max_patterns = 0;
+    for (size_t count = 2; count <= 128; count <<= 1) {
+        while (patterns.size() < count) {
+            patterns.push_back(text.substr((patterns.size() * 7919 + 4099) % (text.size() - 16), 12));
+            patterns.back()[6] ^= 0x55;  // 不出现在文本中，两者都需扫描全文
+        }
+        std::vector<StrView> views(patterns.begin(), patterns.end());
+        TeddyMatcher teddy(views);
+        AhoCorasick automaton(patterns);
+
+        double teddy_time = best_of_two([&]() { (void)teddy.find_present(part, 1); });
+        double multi = best_of_two([&]() { (void)automaton.find_present(part, 1); });
+        if (teddy_time >= multi) break;
+        config.teddy_max_patterns = count;
+    }
+
+    return config;
+}
+
+double pattern_entropy(StrView pattern) {
+    if (pattern.empty()) return 0.0;
+
+    size_t freq[256] = {};
+    for (unsigned char c : pattern) ++freq[c];
+
+    double entropy = 0.0;
+    const double n = static_cast<double>(pattern.size());
+    for (size_t f : freq) {
+        if (f == 0) continue;
+        double p = static_cast<double>(f) / n;
+        entropy -= p * std::log2(p);
+    }
+    return entropy;
+}
+
+MatchAlgo choose_algo(StrView pattern) {
+    const TuningConfig& config = g_tuning;
+    // 单字节模式串熵恒为 0，但首字节过滤正是其最快路径
+    if (pattern.size() > 1 && pattern_entropy(pattern) < config.low_entropy_bits) return config.low_entropy_algo;
+    if (pattern.size() >= config.long_pattern) return config.long_algo;
+    return config.short_algo;
+}
+
+int choose_threads(size_t text_size, int num_threads) {
+    int cores = ThreadPool::instance().worker_count() + 1;
+    size_t by_size = std::max<size_t>(1, text_size / std::max<size_t>(1, g_tuning.min_bytes_per_thread));
+    return static_cast<int>(std::min<size_t>(std::min(std::max(num_threads, 1), cores), by_size));
+}
+
+MatchStrategy choose_strategy(StrView pattern, size_t text_size, int num_threads) {
+    return MatchStrategy{choose_algo(pattern), choose_threads(text_size, num_threads)};
+}
+
+bool prefer_multi_pattern(size_t pattern_count) { return pattern_count >= g_tuning.multi_pattern_min; }
+
+bool prefer_teddy(size_t pattern_count) { return pattern_count >= 2 && pattern_count <= g_tuning.teddy_max_patterns; }
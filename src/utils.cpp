@@ -1,4 +1,10 @@
 #include "utils.hpp"
+#include "dir_walker.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fcntl.h>
 #include <fstream>
 #include <iostream>
@@ -40,18 +46,32 @@ std::vector<char> read_binary_file(const std::string& path) {
     return buffer;
 }
 
+// 由 DirectoryWalker 并行遍历，再按目录项序号恢复串行递归遍历的顺序
 std::vector<std::string> list_all_files(const std::string& root_path) {
-    std::vector<std::string> files;
-
-    for (auto& entry : std::filesystem::recursive_directory_iterator(root_path)) {
-        if (entry.is_regular_file()) {
-            files.push_back(entry.path().string());
-        }
+    std::vector<WalkEntry> entries;
+    {
+        DirectoryWalker walker(root_path);
+        WalkEntry entry;
+        while (walker.next(entry)) entries.push_back(std::move(entry));
     }
+    std::sort(entries.begin(), entries.end(), walk_order_less);
 
+    std::vector<std::string> files;
+    files.reserve(entries.size());
+    for (WalkEntry& entry : entries) files.push_back(std::move(entry.path));
     return files;
 }
 
+bool file_stat(const std::string& path, std::uint64_t& size, std::int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
 double now() {
     auto t = std::chrono::high_resolution_clock::now();
     double seconds = std::chrono::duration<double>(t.time_since_epoch()).count();
@@ -98,6 +118,88 @@ FileView& FileView::operator=(FileView&& other) noexcept {
 }
 
 FileView read_file_view(const std::string& path, size_t mmap_threshold) {
+    return read_file_view(path, mmap_threshold, ReadHints{});
+}
+
+namespace {
+size_t count_carriage_returns(const char* begin, const char* end) {
+    size_t count = 0;
+    while (begin < end) {
+        const void* hit = std::memchr(begin, '\r', static_cast<size_t>(end - begin));
+        if (hit == nullptr) break;
+        ++count;
+        begin = static_cast<const char*>(hit) + 1;
+    }
+    return count;
+}
+
+// 以 '\r' 为界整段复制（memchr / memcpy 都是向量化实现），返回写入的字节数
+size_t copy_without_carriage_returns(const char* begin, const char* end, char* out) {
+    char* start = out;
+    while (begin < end) {
+        const void* hit = std::memchr(begin, '\r', static_cast<size_t>(end - begin));
+        const char* stop = hit == nullptr ? end : static_cast<const char*>(hit);
+        std::memcpy(out, begin, static_cast<size_t>(stop - begin));
+        out += stop - begin;
+        begin = stop + 1;
+    }
+    return static_cast<size_t>(out - start);
+}
+}  // namespace
+
+NormalizedText strip_carriage_returns(std::string_view raw, int num_threads) {
+    NormalizedText text;
+    const int parts = static_cast<int>(std::min<size_t>(std::max(num_threads, 1), std::max<size_t>(raw.size(), 1)));
+    if (parts == 1) {
+        // 单路：不单独计数，找到第一个 '\r' 后按原长度借缓冲区，一遍压缩完成
+        const void* first = std::memchr(raw.data(), '\r', raw.size());
+        if (first == nullptr) {
+            text.view = raw;
+            return text;
+        }
+        text.buffer = BufferPool::instance().acquire(raw.size());
+        const size_t head = static_cast<size_t>(static_cast<const char*>(first) - raw.data());
+        std::memcpy(text.buffer.data(), raw.data(), head);
+        const size_t tail = copy_without_carriage_returns(raw.data() + head + 1, raw.data() + raw.size(),
+                                                          text.buffer.data() + head);
+        text.view = std::string_view(text.buffer.data(), head + tail);
+        return text;
+    }
+    const size_t step = (raw.size() + parts - 1) / parts;
+    auto part_begin = [&](int p) { return raw.data() + std::min(raw.size(), step * p); };
+
+    std::vector<size_t> counts(parts + 1, 0);
+    parallel_for(parts, [&](int p) { counts[p + 1] = count_carriage_returns(part_begin(p), part_begin(p + 1)); });
+    for (int p = 0; p < parts; ++p) counts[p + 1] += counts[p];
+    if (counts[parts] == 0) {
+        text.view = raw;
+        return text;
+    }
+
+    // 第 p 段写到 [part_begin(p) - raw - 前 p 段的 '\r' 数, ...)，各段互不重叠
+    const size_t size = raw.size() - counts[parts];
+    text.buffer = BufferPool::instance().acquire(size);
+    char* out = text.buffer.data();
+    parallel_for(parts, [&](int p) {
+        copy_without_carriage_returns(part_begin(p), part_begin(p + 1),
+                                      out + (part_begin(p) - raw.data()) - counts[p]);
+    });
+    text.view = std::string_view(out, size);
+    return text;
+}
+
+void prefetch_file(const std::string& path) {
+#if defined(__unix__) && defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+FileView read_file_view(const std::string& path, size_t mmap_threshold, ReadHints hints) {
     FileView fv;
 
     struct stat st{};
@@ -112,8 +214,13 @@ FileView read_file_view(const std::string& path, size_t mmap_threshold) {
     if (file_size >= mmap_threshold) {
         int fd = ::open(path.c_str(), O_RDONLY);
         if (fd >= 0) {
-            void* addr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (hints.populate) flags |= MAP_POPULATE;
+#endif
+            void* addr = ::mmap(nullptr, file_size, PROT_READ, flags, fd, 0);
             if (addr != MAP_FAILED) {
+                if (hints.sequential) ::madvise(addr, file_size, MADV_SEQUENTIAL);
                 fv.view = std::string_view(static_cast<const char*>(addr), file_size);
                 fv.mapped = true;
                 fv.fd = fd;
@@ -126,12 +233,38 @@ FileView read_file_view(const std::string& path, size_t mmap_threshold) {
     }
 #else
     (void)mmap_threshold;
+    (void)hints;
 #endif
 
-    fv.buffer = read_binary_file(path);
-    if (!fv.buffer.empty()) {
-        fv.view = std::string_view(fv.buffer.data(), fv.buffer.size());
-        fv.size = fv.buffer.size();
+    // 小文件读入池中的缓冲区：不逐个分配新的 vector，也不先清零
+    fv.size = 0;
+    if (file_size == 0) return fv;
+    PooledBuffer buffer = BufferPool::instance().acquire(file_size);
+    size_t done = 0;
+#ifdef __unix__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Fail to open file: " << path << std::endl;
+        return fv;
+    }
+    while (done < file_size) {
+        ssize_t got = ::read(fd, buffer.data() + done, file_size - done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += static_cast<size_t>(got);
     }
+    ::close(fd);
+#else
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin.is_open()) {
+        std::cout << "Fail to open file: " << path << std::endl;
+        return fv;
+    }
+    fin.read(buffer.data(), static_cast<std::streamsize>(file_size));
+    done = static_cast<size_t>(fin.gcount());
+#endif
+    fv.buffer = std::move(buffer);
+    fv.view = std::string_view(fv.buffer.data(), done);
+    fv.size = done;
     return fv;
 }
@@ -1,5 +1,8 @@
 #include "virus_search.hpp"
-#include "matcher.hpp"
+#include "dir_walker.hpp"
+#include "file_prefetcher.hpp"
+#include "result_writer.hpp"
+#include "signature_set.hpp"
 #include "utils.hpp"
 
 #include <algorithm>
@@ -8,61 +11,130 @@
 #include <iostream>
 #include <string_view>
 
-void run_virus_search(const std::string& input_dir, const std::string& output_path, int num_threads) {
-    // 1. 读取所有病毒段文件（virus01.bin ~ virus10.bin）
-    std::vector<FileView> virus_code;
-    std::vector<std::string> virus_name;
+namespace {
+struct FileResult {
+    std::vector<std::uint32_t> order;
+    std::string file;
+    std::vector<std::string> hit;
+};
 
-    std::string virus_dir = input_dir + "/virus";
-    std::vector<std::string> list_virus = list_all_files(virus_dir);
+// 对一个文件只扫描一次，得到其中出现的全部病毒；大文件的扫描本身按文件大小再并行
+std::vector<std::string> scan_buffer(const SignatureSet& signatures, std::string_view text, int num_threads) {
+    std::vector<std::string> hit;
 
-    std::sort(list_virus.begin(), list_virus.end());
-
-    for (const std::string& path : list_virus) {
-        FileView fv = read_file_view(path);
-        if (fv.view.empty()) continue;  // 读失败则跳过
-        virus_code.push_back(std::move(fv));
-        virus_name.push_back(std::filesystem::path(path).filename().string());
+    for (int id : signatures.scan(text, num_threads)) {
+        hit.push_back(signatures.name(id));
     }
+    return hit;
+}
 
-    // 2. 遍历软件目录（opencv-4.10.0）
-
-    std::string soft_dir = input_dir + "/opencv-4.10.0";
-    std::vector<std::string> files = list_all_files(soft_dir);
-
-    // 3. 对每个文件匹配病毒
-    std::vector<std::pair<std::string, std::vector<std::string>>> results;
-
-    for (const std::string& file : files) {
-        FileView file_view = read_file_view(file);
-        std::string_view text = file_view.view;
+// 发现顺序：文件一被遍历到就由 workers 个扫描线程取走，遍历与匹配重叠
+std::vector<FileResult> scan_in_discovery_order(const SignatureSet& signatures, const std::string& soft_dir,
+                                                int num_threads) {
+    DirectoryWalker walker(soft_dir);
+    const int workers = std::max(num_threads, 1);
+    std::vector<std::vector<FileResult>> worker_results(workers);
+
+    parallel_for(workers, [&](int worker) {
+        WalkEntry entry;
+        while (walker.next(entry)) {
+            FileView file_view = read_file_view(entry.path);
+            std::vector<std::string> hit = scan_buffer(signatures, file_view.view, num_threads);
+            if (!hit.empty()) {
+                worker_results[worker].push_back({std::move(entry.order), std::move(entry.path), std::move(hit)});
+            }
+        }
+    });
 
-        std::vector<std::string> hit;
+    std::vector<FileResult> results;
+    for (auto& part : worker_results) {
+        for (FileResult& result : part) results.push_back(std::move(result));
+    }
+    return results;
+}
 
-        for (size_t i = 0; i < virus_code.size(); ++i) {
+// 大文件优先：先遍历完整棵树（取文件大小与遍历重叠），再按大小降序派发，每个文件一个任务。
+// 大文件先开始、小文件填补尾部，避免最后剩一个大文件单独拖长总时间；大文件内部仍按大小切块并行。
+// 文件由 FilePrefetcher 按同一顺序提前读入（沿用这里取到的大小，不再逐个 stat），匹配线程不等待磁盘，在途内存有上界
+std::vector<FileResult> scan_largest_first(const SignatureSet& signatures, const std::string& soft_dir,
+                                           int num_threads) {
+    struct SizedEntry {
+        WalkEntry entry;
+        std::uintmax_t size;
+    };
+    const int workers = std::max(num_threads, 1);
+    std::vector<std::vector<SizedEntry>> found(workers);
+    {
+        DirectoryWalker walker(soft_dir);
+        parallel_for(workers, [&](int worker) {
+            WalkEntry entry;
+            while (walker.next(entry)) {
+                std::error_code ec;
+                std::uintmax_t size = std::filesystem::file_size(entry.path, ec);
+                found[worker].push_back({std::move(entry), ec ? 0 : size});
+            }
+        });
+    }
 
-            const auto& viru = virus_code[i].view;
+    std::vector<SizedEntry> files;
+    for (auto& part : found) {
+        for (SizedEntry& file : part) files.push_back(std::move(file));
+    }
+    // 大小相同按遍历顺序，派发顺序也是确定的
+    std::sort(files.begin(), files.end(), [](const SizedEntry& a, const SizedEntry& b) {
+        if (a.size != b.size) return a.size > b.size;
+        return walk_order_less(a.entry, b.entry);
+    });
+
+    std::vector<std::string> paths;
+    std::vector<size_t> sizes;
+    paths.reserve(files.size());
+    sizes.reserve(files.size());
+    for (const SizedEntry& file : files) {
+        paths.push_back(file.entry.path);
+        sizes.push_back(static_cast<size_t>(file.size));
+    }
 
-            auto pos = binary_match_parallel(text, viru, num_threads);
+    std::vector<std::vector<std::string>> hits(files.size());
+    FilePrefetcher prefetcher(std::move(paths), std::move(sizes));
+    parallel_for(workers, [&](int) {
+        PrefetchedFile file;
+        while (prefetcher.next(file)) hits[file.index()] = scan_buffer(signatures, file.view(), num_threads);
+    });
+
+    std::vector<FileResult> results;
+    for (size_t k = 0; k < files.size(); ++k) {
+        if (hits[k].empty()) continue;
+        results.push_back({std::move(files[k].entry.order), std::move(files[k].entry.path), std::move(hits[k])});
+    }
+    return results;
+}
+}  // namespace
 
-            if (!pos.empty()) {
-                hit.push_back(virus_name[i]);
-            }
-        }
+void run_virus_search(const std::string& input_dir, const std::string& output_path, int num_threads,
+                      ScanOrder order) {
+    // 1. 读取所有病毒段文件（virus01.bin ~ virus10.bin），编译为一个特征集合
+    SignatureSet signatures = SignatureSet::load_directory(input_dir + "/virus");
 
-        if (!hit.empty()) {
-            results.push_back({file, hit});
-        }
-    }
+    // 2. 并行遍历软件目录（opencv-4.10.0），多个文件同时扫描
+    std::string soft_dir = input_dir + "/opencv-4.10.0";
+    std::vector<FileResult> results = order == ScanOrder::LargestFirst
+                                          ? scan_largest_first(signatures, soft_dir, num_threads)
+                                          : scan_in_discovery_order(signatures, soft_dir, num_threads);
 
-    std::ofstream fout(output_path);
+    // 3. 按串行递归遍历的顺序输出，与线程数、调度方式和完成先后无关
+    std::sort(results.begin(), results.end(),
+              [](const FileResult& a, const FileResult& b) { return a.order < b.order; });
 
+    // 拼成一块后一次写出
+    std::string out;
     for (const auto& result : results) {
-
-        fout << result.first;
-        for (const std::string& viru : result.second) {
-            fout << " " << viru;
+        out += result.file;
+        for (const std::string& viru : result.hit) {
+            out += ' ';
+            out += viru;
         }
-        fout << std::endl;
+        out += '\n';
     }
+    write_text_file(output_path, out);
 }
@@ -1,24 +1,92 @@
 /**
  * Performance benchmark tool.
- * Usage: ./test_performance <data_root> [repeat=3]
+ * Usage: ./test_performance <data_root> [repeat=3] [--large <GiB>]
  * data_root should contain document_retrieval/ and software_antivirus/ directories.
+ * --large additionally runs a synthetic multi-GB text benchmark to exercise 64-bit offsets.
  */
 
+#include "batch_reader.hpp"
+#include "buffer_pool.hpp"
+#include "doc_index.hpp"
+#include "file_prefetcher.hpp"
 #include "matcher.hpp"
+#include "result_writer.hpp"
+#include "stream_matcher.hpp"
+#include "thread_pool.hpp"
+#include "tuning.hpp"
 #include "utils.hpp"
+#include "virus_search.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <new>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+// 基准程序内替换全局 operator new / delete：只在 AllocationCounter 存活期间统计堆分配次数与同时存活的分配数峰值，
+// 用于在同一口径下对比逐个 vector 读取与 BufferPool 的分配情况
+namespace {
+std::atomic<bool> g_count_allocations{false};
+std::atomic<size_t> g_allocations{0};
+std::atomic<long> g_live_allocations{0};
+std::atomic<long> g_peak_live_allocations{0};
+}  // namespace
+
+void* operator new(size_t size) {
+    if (g_count_allocations.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        long live = g_live_allocations.fetch_add(1, std::memory_order_relaxed) + 1;
+        long peak = g_peak_live_allocations.load(std::memory_order_relaxed);
+        while (live > peak && !g_peak_live_allocations.compare_exchange_weak(peak, live)) {
+        }
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr && g_count_allocations.load(std::memory_order_relaxed)) {
+        g_live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    }
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+// 统计区间：构造时清零并开始计数，析构时停止
+struct AllocationCounter {
+    AllocationCounter() {
+        g_allocations.store(0);
+        g_live_allocations.store(0);
+        g_peak_live_allocations.store(0);
+        g_count_allocations.store(true);
+    }
+    ~AllocationCounter() { g_count_allocations.store(false); }
+
+    size_t allocations() const { return g_allocations.load(); }
+    long peak_live() const { return g_peak_live_allocations.load(); }
+};
 
 struct DocData {
     FileView text_view;
@@ -32,8 +100,8 @@ struct VirusData {
     std::vector<std::string> files;
 };
 
-using MatchFunc = std::vector<int> (*)(std::string_view, std::string_view, int);
-using BinMatchFunc = std::vector<int> (*)(std::string_view, std::string_view, int);
+using MatchFunc = std::vector<MatchPos> (*)(std::string_view, std::string_view, int);
+using BinMatchFunc = std::vector<MatchPos> (*)(std::string_view, std::string_view, int);
 
 double measure_seconds(const std::function<void()>& fn) {
     auto t0 = std::chrono::steady_clock::now();
@@ -101,6 +169,705 @@ double bench_virus(const VirusData& data, BinMatchFunc func, int threads, int re
     return total / repeat;
 }
 
+// 单次文档检索的逐模式延迟统计（毫秒），用于观察分块大小对尾延迟的影响
+struct LatencyStats {
+    double total_seconds{0.0};
+    double p50_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+};
+
+LatencyStats bench_doc_latency(const DocData& data, MatchFunc func, int threads, int repeat) {
+    std::vector<double> samples;
+    double total = 0.0;
+    for (int i = 0; i < repeat; ++i) {
+        for (const auto& pattern : data.patterns) {
+            double t = measure_seconds([&]() { (void)func(data.text, std::string_view(pattern), threads); });
+            samples.push_back(t * 1000.0);
+            total += t;
+        }
+    }
+
+    LatencyStats stats;
+    stats.total_seconds = total / repeat;
+    if (samples.empty()) return stats;
+    std::sort(samples.begin(), samples.end());
+    auto pick = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    stats.p50_ms = pick(0.50);
+    stats.p99_ms = pick(0.99);
+    stats.max_ms = samples.back();
+    return stats;
+}
+
+void print_chunk_sweep(const DocData& data, const std::vector<size_t>& chunk_sizes, int threads,
+                       const std::vector<std::pair<std::string, MatchFunc>>& funcs, int repeat) {
+    std::cout << "==== chunk size sweep (document retrieval) ====\n";
+    std::cout << "algorithm,chunk_kib,threads,avg_seconds,p50_ms,p99_ms,max_ms,speedup\n";
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& item : funcs) {
+        for (size_t chunk : chunk_sizes) {
+            set_match_chunk_size(chunk);
+            LatencyStats base = bench_doc_latency(data, item.second, 1, repeat);
+            LatencyStats st = bench_doc_latency(data, item.second, threads, repeat);
+            double speedup = (st.total_seconds > 0.0) ? (base.total_seconds / st.total_seconds) : 0.0;
+            std::cout << item.first << "," << chunk / 1024 << "," << threads << "," << st.total_seconds << ","
+                      << st.p50_ms << "," << st.p99_ms << "," << st.max_ms << "," << speedup << "\n";
+        }
+    }
+    set_match_chunk_size(0);
+    std::cout << std::endl;
+}
+
+// 病毒特征只编译一次，在所有文件与线程之间共享预处理表；扫描只需判断是否出现，使用 exists 模式提前结束
+double bench_virus_compiled(const VirusData& data, MatchAlgo algo, int threads, int repeat) {
+    std::vector<CompiledPattern> compiled;
+    for (const auto& virus : data.viruses) compiled.emplace_back(virus.view, algo);
+
+    double total = 0.0;
+    for (int i = 0; i < repeat; ++i) {
+        total += measure_seconds([&]() {
+            for (const auto& file : data.files) {
+                FileView file_view = read_file_view(file);
+                std::string_view text(file_view.view);
+                for (const auto& pattern : compiled) {
+                    (void)binary_match_exists(text, pattern, threads);
+                }
+            }
+        });
+    }
+    return total / repeat;
+}
+
+// 病毒特征集合的三种扫描引擎：逐个特征 exists、Aho-Corasick、Teddy，均只判断出现与否。
+// 文件预先读入内存，只比较匹配本身；identical 与逐个特征的结果对比
+void bench_signature_engines(const VirusData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== software antivirus (signature engines) ====\n";
+    std::cout << "method,signatures,threads,avg_seconds,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    std::vector<std::string_view> signatures;
+    for (const FileView& virus : data.viruses) signatures.push_back(virus.view);
+    std::vector<CompiledPattern> compiled;
+    for (std::string_view signature : signatures) compiled.emplace_back(signature, MatchAlgo::Auto);
+    const AhoCorasick automaton(signatures);
+    const TeddyMatcher teddy(signatures);
+
+    std::vector<FileView> files;
+    for (const std::string& file : data.files) files.push_back(read_file_view(file));
+
+    using Presence = std::vector<std::vector<int>>;
+    auto per_signature = [&](int th) {
+        Presence present;
+        for (const FileView& file : files) {
+            present.emplace_back();
+            for (size_t id = 0; id < compiled.size(); ++id) {
+                if (binary_match_exists(file.view, compiled[id], th)) present.back().push_back(static_cast<int>(id));
+            }
+        }
+        return present;
+    };
+    const Presence expected = per_signature(1);
+
+    auto report = [&](const std::string& method, int th, const std::function<Presence()>& fn) {
+        double total = 0.0;
+        bool identical = true;
+        for (int r = 0; r < repeat; ++r) {
+            Presence present;
+            total += measure_seconds([&]() { present = fn(); });
+            identical = identical && present == expected;
+        }
+        std::cout << method << "," << signatures.size() << "," << th << "," << total / repeat << ","
+                  << (identical ? "yes" : "no") << "\n";
+    };
+    for (int th : thread_counts) {
+        report("per_signature", th, [&]() { return per_signature(th); });
+        report("aho_corasick", th, [&]() {
+            Presence present;
+            for (const FileView& file : files) present.push_back(automaton.find_present(file.view, th));
+            return present;
+        });
+        report("teddy", th, [&]() {
+            Presence present;
+            for (const FileView& file : files) present.push_back(teddy.find_present(file.view, th));
+            return present;
+        });
+    }
+    std::cout << std::endl;
+}
+
+// 合成的大文本：随机小写字母，在 2 GiB 边界两侧（跨越边界的一处）及末尾埋入模式串，校验 64 位偏移是否正确
+void bench_large(size_t gib, const std::vector<int>& thread_counts) {
+    const std::string pattern = "needle-in-a-haystack";
+    const size_t n = gib << 30;
+
+    std::string text;
+    try {
+        text.resize(n);
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Fail to allocate " << gib << " GiB for large benchmark\n";
+        return;
+    }
+    unsigned long long state = 88172645463325252ULL;
+    for (size_t i = 0; i < n; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        text[i] = static_cast<char>('a' + state % 26);
+    }
+
+    std::vector<MatchPos> planted;
+    for (size_t pos : {size_t(1) << 20, (size_t(1) << 31) - 7, (size_t(1) << 31) + 64, n - pattern.size()}) {
+        if (pos + pattern.size() > n) continue;
+        text.replace(pos, pattern.size(), pattern);
+        planted.push_back(static_cast<MatchPos>(pos));
+    }
+    std::sort(planted.begin(), planted.end());
+    planted.erase(std::unique(planted.begin(), planted.end()), planted.end());
+
+    std::vector<std::pair<std::string, MatchFunc>> funcs = {
+        {"sunday", match_parallel_sunday},
+        {"bm", match_parallel_bm},
+        {"simd", match_parallel_simd},
+    };
+
+    std::cout << "==== large synthetic text (" << gib << " GiB) ====\n";
+    std::cout << "algorithm,threads,seconds,gib_per_second,correct\n";
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& item : funcs) {
+        for (int th : thread_counts) {
+            std::vector<MatchPos> found;
+            double t = measure_seconds([&]() { found = item.second(text, pattern, th); });
+            double rate = (t > 0.0) ? (static_cast<double>(gib) / t) : 0.0;
+            std::cout << item.first << "," << th << "," << t << "," << rate << ","
+                      << (found == planted ? "yes" : "no") << "\n";
+        }
+    }
+    std::cout << std::endl;
+}
+
+// 流式匹配：把文档切成固定大小的分段依次 feed，与整段匹配结果比较，观察分段大小对吞吐的影响
+void bench_stream(const DocData& data, const std::vector<size_t>& buffer_sizes,
+                  const std::vector<std::pair<std::string, MatchAlgo>>& algos, int repeat) {
+    std::cout << "==== document retrieval (streaming, single thread) ====\n";
+    std::cout << "algorithm,buffer_kib,avg_seconds,correct\n";
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& item : algos) {
+        std::vector<CompiledPattern> compiled;
+        std::vector<std::vector<MatchPos>> expected;
+        for (const auto& pattern : data.patterns) {
+            compiled.emplace_back(pattern, item.second);
+            expected.push_back(compiled.back().match(data.text));
+        }
+        for (size_t buffer : buffer_sizes) {
+            bool correct = true;
+            double total = 0.0;
+            for (int r = 0; r < repeat; ++r) {
+                total += measure_seconds([&]() {
+                    for (size_t k = 0; k < compiled.size(); ++k) {
+                        StreamMatcher stream(compiled[k]);
+                        std::vector<MatchPos> positions;
+                        for (size_t pos = 0; pos < data.text.size(); pos += buffer) {
+                            stream.feed(data.text.substr(pos, buffer), positions);
+                        }
+                        correct = correct && positions == expected[k];
+                    }
+                });
+            }
+            std::cout << item.first << "," << (buffer >> 10) << "," << total / repeat << ","
+                      << (correct ? "yes" : "no") << "\n";
+        }
+    }
+    std::cout << std::endl;
+}
+
+// 后缀数组索引：构建耗时随线程数的变化，以及建好后逐模式查询与 Aho-Corasick 整篇扫描的对比
+void bench_doc_index(const DocData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== document retrieval (suffix array index) ====\n";
+    std::cout << "phase,threads,avg_seconds,correct\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    SuffixArrayIndex index;
+    for (int th : thread_counts) {
+        double total = 0.0;
+        for (int r = 0; r < repeat; ++r) {
+            total += measure_seconds([&]() { index = SuffixArrayIndex::build(data.text, th); });
+        }
+        std::cout << "build," << th << "," << total / repeat << ",-\n";
+    }
+
+    const int max_threads = thread_counts.back();
+    AhoCorasick automaton(data.patterns);
+    std::vector<std::vector<MatchPos>> expected;
+    double scan = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        scan += measure_seconds([&]() { expected = automaton.match_parallel(data.text, max_threads); });
+    }
+
+    std::vector<std::vector<MatchPos>> found(data.patterns.size());
+    double query = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        query += measure_seconds([&]() {
+            for (size_t k = 0; k < data.patterns.size(); ++k) found[k] = index.find(data.patterns[k]);
+        });
+    }
+    std::cout << "query,1," << query / repeat << "," << (found == expected ? "yes" : "no") << "\n";
+    std::cout << "aho_corasick_scan," << max_threads << "," << scan / repeat << ",-\n";
+    std::cout << std::endl;
+}
+
+// 结果写出：原先逐个 operator<< 加 std::endl，与并行 to_chars 文本格式、差分 + varint 二进制格式对比。
+// 输出写到系统临时目录后删除，字节数反映各格式的体积
+void bench_result_writer(const DocData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== result writer ====\n";
+    std::cout << "format,threads,avg_seconds,bytes\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    AhoCorasick automaton(data.patterns);
+    std::vector<std::vector<MatchPos>> positions = automaton.match_parallel(data.text, thread_counts.back());
+    const std::string path = (std::filesystem::temp_directory_path() / "psm_bench_result").string();
+
+    double total = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        total += measure_seconds([&]() {
+            std::ofstream fout(path);
+            for (const auto& p : positions) {
+                fout << p.size();
+                for (MatchPos pos : p) fout << " " << pos;
+                fout << std::endl;
+            }
+        });
+    }
+    std::cout << "ostream_endl,1," << total / repeat << "," << std::filesystem::file_size(path) << "\n";
+
+    for (ResultFormat format : {ResultFormat::Text, ResultFormat::Binary}) {
+        for (int th : thread_counts) {
+            total = 0.0;
+            for (int r = 0; r < repeat; ++r) {
+                total += measure_seconds([&]() { write_position_lists(path, positions, th, format); });
+            }
+            std::cout << (format == ResultFormat::Text ? "text" : "binary") << "," << th << "," << total / repeat
+                      << "," << std::filesystem::file_size(path) << "\n";
+        }
+    }
+    std::filesystem::remove(path);
+    std::cout << std::endl;
+}
+
+// 文档 '\r' 规范化：原先复制成 std::string 再 erase(remove)，与按段计数 + 并行压缩（无 '\r' 时零复制）对比
+void bench_crlf(const DocData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== crlf normalization ====\n";
+    std::cout << "method,threads,avg_seconds,extra_bytes,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    std::string expected;
+    double total = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        total += measure_seconds([&]() {
+            expected.assign(data.text);
+            expected.erase(std::remove(expected.begin(), expected.end(), '\r'), expected.end());
+        });
+    }
+    std::cout << "string_erase,1," << total / repeat << "," << data.text.size() << ",yes\n";
+
+    for (int th : thread_counts) {
+        total = 0.0;
+        bool identical = true;
+        size_t extra = 0;
+        for (int r = 0; r < repeat; ++r) {
+            NormalizedText text;
+            total += measure_seconds([&]() { text = strip_carriage_returns(data.text, th); });
+            identical = identical && text.view == expected;
+            extra = text.buffer.capacity();
+        }
+        std::cout << "strip_parallel," << th << "," << total / repeat << "," << extra << ","
+                  << (identical ? "yes" : "no") << "\n";
+    }
+    std::cout << std::endl;
+}
+
+// 调用线程的硬件计数器（perf_event_open，只计用户态）；虚拟机等没有 PMU 或权限不足时 available() 为 false
+class PerfCounter {
+  public:
+    explicit PerfCounter(std::uint64_t config) {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)config;
+#endif
+    }
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+    // 计时 fn 期间的计数
+    std::uint64_t measure(const std::function<void()>& fn) {
+        std::uint64_t value = 0;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            fn();
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+            return value;
+        }
+#endif
+        fn();
+        return value;
+    }
+
+  private:
+    int fd_{-1};
+};
+
+// 多个单模式：逐个模式串整篇扫描与按 L2 大小分块执行（每块跑完全部模式串）对比。
+// 有效吞吐按 文本字节数 × 模式串数 计；LLC 未命中数只统计调用线程，因此只在单线程时给出
+void bench_tiled(const DocData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== tiled multi pattern ====\n";
+    std::cout << "method,threads,avg_seconds,effective_gb_per_s,llc_misses,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    std::vector<CompiledPattern> compiled;
+    for (const std::string& pattern : data.patterns) compiled.emplace_back(pattern, MatchAlgo::Auto);
+    const double bytes = static_cast<double>(data.text.size()) * static_cast<double>(compiled.size());
+
+    std::vector<std::vector<MatchPos>> expected;
+    for (const CompiledPattern& pattern : compiled) expected.push_back(match_parallel(data.text, pattern, 1));
+
+    PerfCounter llc(PERF_COUNT_HW_CACHE_MISSES);
+    auto per_pattern = [&](int th) {
+        std::vector<std::vector<MatchPos>> positions;
+        for (const CompiledPattern& pattern : compiled) positions.push_back(match_parallel(data.text, pattern, th));
+        return positions;
+    };
+    auto tiled = [&](int th) { return match_parallel_tiled(data.text, compiled, th); };
+    auto run = [&](const char* name, const std::function<std::vector<std::vector<MatchPos>>(int)>& fn) {
+        for (int th : thread_counts) {
+            double total = 0.0;
+            std::uint64_t misses = 0;
+            bool identical = true;
+            for (int r = 0; r < repeat; ++r) {
+                std::vector<std::vector<MatchPos>> positions;
+                total += measure_seconds([&]() { misses += llc.measure([&]() { positions = fn(th); }); });
+                identical = identical && positions == expected;
+            }
+            const double seconds = total / repeat;
+            std::cout << name << "," << th << "," << seconds << "," << bytes / seconds / 1e9 << ",";
+            if (llc.available() && th == 1) {
+                std::cout << misses / static_cast<std::uint64_t>(repeat);
+            } else {
+                std::cout << "-";
+            }
+            std::cout << "," << (identical ? "yes" : "no") << "\n";
+        }
+    };
+    run("per_pattern", per_pattern);
+    run("tiled", tiled);
+    std::cout << std::endl;
+}
+
+// 批量匹配：逐个 match_parallel 与 match_batch 各并行方式对比；小文本上单模式并发受 n / m 与每路最小字节数限制
+void bench_batch(const DocData& data, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== batch match ====\n";
+    std::cout << "text_bytes,method,threads,avg_seconds,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    using PositionLists = std::vector<std::vector<MatchPos>>;
+    std::vector<CompiledPattern> compiled;
+    for (const std::string& pattern : data.patterns) compiled.emplace_back(pattern, MatchAlgo::Auto);
+    const char* names[] = {"batch_auto", "batch_patterns", "batch_text", "batch_both"};
+
+    for (size_t size : {size_t(64) << 10, data.text.size()}) {
+        const std::string_view text = data.text.substr(0, size);
+        PositionLists expected;
+        for (const CompiledPattern& pattern : compiled) expected.push_back(match_parallel(text, pattern, 1));
+
+        auto report = [&](const std::string& method, int th, const std::function<PositionLists()>& fn) {
+            double total = 0.0;
+            bool identical = true;
+            for (int r = 0; r < repeat; ++r) {
+                PositionLists positions;
+                total += measure_seconds([&]() { positions = fn(); });
+                identical = identical && positions == expected;
+            }
+            std::cout << text.size() << "," << method << "," << th << "," << total / repeat << ","
+                      << (identical ? "yes" : "no") << "\n";
+        };
+        for (int th : thread_counts) {
+            report("per_pattern", th, [&]() {
+                PositionLists positions;
+                for (const CompiledPattern& pattern : compiled) positions.push_back(match_parallel(text, pattern, th));
+                return positions;
+            });
+            for (int k = 0; k < 4; ++k) {
+                const BatchStrategy strategy = static_cast<BatchStrategy>(k);
+                std::string method = names[k];
+                if (strategy == BatchStrategy::Auto) {
+                    const BatchStrategy chosen = choose_batch_strategy(text.size(), compiled.size(), th);
+                    method += std::string("(") + names[static_cast<int>(chosen)] + ")";
+                }
+                report(method, th, [&]() { return match_batch(text, compiled, BatchOptions{th, strategy}); });
+            }
+        }
+    }
+    std::cout << std::endl;
+}
+
+// 最坏情况语料：重复文本上命中密集或每个窗口都要比较大半个模式串，朴素实现退化为 O(n·m)
+struct WorstCase {
+    std::string name;
+    std::string text;
+    std::string pattern;
+};
+
+std::vector<WorstCase> make_worst_case_corpus(size_t text_bytes, size_t pattern_bytes) {
+    const size_t half = pattern_bytes / 2;
+    std::string periodic;
+    while (periodic.size() < text_bytes) periodic += "ab";
+    return {
+        // 每个位置都命中：命中后只移 1 的实现每次重新比较整个模式串
+        {"all_a/all_a", std::string(text_bytes, 'a'), std::string(pattern_bytes, 'a')},
+        // 首字节失配：从左向右比较的算法每个窗口比较 m-1 字节
+        {"all_a/a..ab", std::string(text_bytes, 'a'), std::string(pattern_bytes - 1, 'a') + "b"},
+        // 中间失配：两端的字节过滤与坏字符位移都不起作用
+        {"all_a/a..ba..a", std::string(text_bytes, 'a'), std::string(half, 'a') + "b" + std::string(half, 'a')},
+        // 周期为 2 的文本与模式串：命中间隔为 2
+        {"abab/abab", periodic, periodic.substr(0, pattern_bytes)},
+    };
+}
+
+// 最坏情况语料上各算法的单线程耗时；匹配结果以 KMP 为准
+void bench_worst_case(int repeat) {
+    std::cout << "==== worst-case inputs (single thread) ====\n";
+    std::cout << "corpus,algorithm,avg_seconds,matches,correct\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    const std::vector<std::pair<std::string, MatchFunc>> funcs = {
+        {"bf", match_parallel_bf},         {"kmp", match_parallel_kmp},   {"sunday", match_parallel_sunday},
+        {"bm", match_parallel_bm},         {"simd", match_parallel_simd}, {"shift_or", match_parallel_shift_or},
+        {"bndm", match_parallel_bndm},     {"bom", match_parallel_bom},   {"two_way", match_parallel_two_way},
+    };
+    for (const WorstCase& item : make_worst_case_corpus(size_t(4) << 20, 256)) {
+        const std::vector<MatchPos> expected = match_parallel_kmp(item.text, item.pattern, 1);
+        for (const auto& func : funcs) {
+            std::vector<MatchPos> found;
+            double total = 0.0;
+            for (int r = 0; r < repeat; ++r) {
+                total += measure_seconds([&]() { found = func.second(item.text, item.pattern, 1); });
+            }
+            std::cout << item.name << "," << func.first << "," << total / repeat << "," << found.size() << ","
+                      << (found == expected ? "yes" : "no") << "\n";
+        }
+    }
+    std::cout << std::endl;
+}
+
+// 病毒扫描整条流水线（遍历 + 多文件并行扫描 + 写出）：大文件优先与边遍历边扫描两种派发顺序，输出应与单线程一致
+void bench_virus_pipeline(const std::string& data_root, const std::vector<int>& thread_counts, int repeat) {
+    std::cout << "==== virus scan pipeline ====\n";
+    std::cout << "order,threads,avg_seconds,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    const std::string input_dir = data_root + "/software_antivirus";
+    const std::string out_dir = (std::filesystem::temp_directory_path() / "psm_bench_virus").string();
+    std::filesystem::create_directories(out_dir);
+    const std::string baseline_path = out_dir + "/baseline.txt";
+    const std::string out_path = out_dir + "/result.txt";
+    run_virus_search(input_dir, baseline_path, 1);
+    const std::string baseline = read_text_file(baseline_path);
+
+    for (ScanOrder order : {ScanOrder::LargestFirst, ScanOrder::Discovery}) {
+        for (int th : thread_counts) {
+            double total = 0.0;
+            for (int r = 0; r < repeat; ++r) {
+                total += measure_seconds([&]() { run_virus_search(input_dir, out_path, th, order); });
+            }
+            std::cout << (order == ScanOrder::LargestFirst ? "largest_first" : "discovery") << "," << th << ","
+                      << total / repeat << "," << (read_text_file(out_path) == baseline ? "yes" : "no") << "\n";
+        }
+    }
+    std::filesystem::remove_all(out_dir);
+    std::cout << std::endl;
+}
+
+#ifdef __linux__
+// read_file_view 小文件分支的计数副本：stat、open、read（直到读满）、close，按 BatchReader::syscall_count 的口径
+// 逐个计数。返回本文件的系统调用数，读到的内容放入 buffer
+size_t read_small_file_counted(const std::string& path, std::string& buffer) {
+    size_t calls = 1;
+    buffer.clear();
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) return calls;
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) return calls;
+    buffer.resize(size);
+    ++calls;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return calls;
+    size_t done = 0;
+    while (done < size) {
+        ++calls;
+        ssize_t got = ::read(fd, &buffer[done], size - done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += static_cast<size_t>(got);
+    }
+    buffer.resize(done);
+    ++calls;
+    ::close(fd);
+    return calls;
+}
+#endif
+
+// 小文件批量读取：逐个 read_file_view 与 BatchReader（io_uring、同步回退）的吞吐和每文件系统调用数
+void bench_batch_reader(const std::string& data_root, int repeat) {
+    std::cout << "==== small file batch read ====\n";
+    std::cout << "mode,files,avg_seconds,files_per_sec,syscalls_per_file,identical\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    const size_t small_limit = 8 * 1024 * 1024;
+    std::vector<std::string> paths;
+    for (std::string& path : list_all_files(data_root + "/software_antivirus")) {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (file_stat(path, size, mtime) && size < small_limit) paths.push_back(std::move(path));
+    }
+    if (paths.empty()) {
+        std::cout << std::endl;
+        return;
+    }
+    std::vector<std::string> expected;
+    for (const std::string& path : paths) expected.emplace_back(read_file_view(path, small_limit).view);
+
+    // 现有路径：逐个 read_file_view 计时；系统调用数由其小文件分支的计数副本另读一遍统计
+    double legacy = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        legacy += measure_seconds([&]() {
+            for (const std::string& path : paths) read_file_view(path, small_limit);
+        });
+    }
+    legacy /= repeat;
+    std::string legacy_calls = "-";
+    bool legacy_identical = true;
+#ifdef __linux__
+    size_t calls = 0;
+    std::string buffer;
+    for (size_t k = 0; k < paths.size(); ++k) {
+        calls += read_small_file_counted(paths[k], buffer);
+        legacy_identical = legacy_identical && buffer == expected[k];
+    }
+    std::ostringstream per_file;
+    per_file << std::fixed << std::setprecision(4) << static_cast<double>(calls) / static_cast<double>(paths.size());
+    legacy_calls = per_file.str();
+#endif
+    std::cout << "read_file_view," << paths.size() << "," << legacy << "," << paths.size() / legacy << ","
+              << legacy_calls << "," << (legacy_identical ? "yes" : "no") << "\n";
+
+    for (bool allow_io_uring : {true, false}) {
+        BatchReader reader(64, allow_io_uring);
+        std::vector<BatchFile> out(paths.size());
+        reader.read(paths.data(), paths.size(), out.data());  // 预热：建立 io_uring 工作线程、分配缓冲区
+        const size_t warm_calls = reader.syscall_count();
+        double total = 0.0;
+        for (int r = 0; r < repeat; ++r) {
+            total += measure_seconds([&]() { reader.read(paths.data(), paths.size(), out.data()); });
+        }
+        total /= repeat;
+        bool identical = true;
+        for (size_t k = 0; k < paths.size() && identical; ++k) {
+            identical = out[k].ok && out[k].view() == expected[k];
+        }
+        const size_t reads = static_cast<size_t>(repeat) * paths.size();
+        const double calls = static_cast<double>(reader.syscall_count() - warm_calls) / static_cast<double>(reads);
+        std::cout << (reader.uses_io_uring() ? "batch_io_uring" : "batch_fallback") << "," << paths.size() << ","
+                  << total << "," << paths.size() / total << "," << calls << "," << (identical ? "yes" : "no")
+                  << "\n";
+    }
+    std::cout << std::endl;
+}
+
+// 小文件缓冲区：逐个分配 vector 与 BufferPool 复用的对比，报告首轮（冷池）与稳态的分配次数和借出峰值
+void bench_buffer_pool(const std::string& data_root, int repeat) {
+    std::cout << "==== small file buffer pool ====\n";
+    std::cout << "mode,files,avg_seconds,allocations,reuses,peak_live\n";
+    std::cout << std::fixed << std::setprecision(4);
+
+    const size_t small_limit = BufferPool::kMaxClassBytes;
+    std::vector<std::string> paths;
+    for (std::string& path : list_all_files(data_root + "/software_antivirus")) {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (file_stat(path, size, mtime) && size > 0 && size < small_limit) paths.push_back(std::move(path));
+    }
+    if (paths.empty()) {
+        std::cout << std::endl;
+        return;
+    }
+
+    // 原先的路径：每个文件一个新 vector（清零后读入），扫描完即释放。分配次数与峰值由 operator new 计数实测，
+    // 包含 ifstream 自身的缓冲区；逐个分配的内存不会被复用，reuses 恒为 0
+    double total = 0.0;
+    size_t vector_allocations = 0;
+    long vector_peak = 0;
+    {
+        AllocationCounter counter;
+        for (int r = 0; r < repeat; ++r) {
+            total += measure_seconds([&]() {
+                for (const std::string& path : paths) read_binary_file(path);
+            });
+        }
+        vector_allocations = counter.allocations();
+        vector_peak = counter.peak_live();
+    }
+    std::cout << "vector," << paths.size() << "," << total / repeat << "," << vector_allocations << ",0,"
+              << vector_peak << "\n";
+
+    BufferPool& pool = BufferPool::instance();
+    const size_t held = pool.stats().live;  // 其他持有者（如已读入的病毒片段）占用的缓冲区，不计入峰值
+    auto report = [&](const char* mode, double seconds) {
+        const BufferPoolStats stats = pool.stats();
+        std::cout << mode << "," << paths.size() << "," << seconds << "," << stats.allocations << "," << stats.reuses
+                  << "," << stats.peak_live - held << "\n";
+        pool.reset_stats();
+    };
+    auto scan_pass = [&]() {
+        for (const std::string& path : paths) read_file_view(path, small_limit);
+    };
+
+    pool.trim();
+    pool.reset_stats();
+    report("pool_first_pass", measure_seconds(scan_pass));
+    total = 0.0;
+    for (int r = 0; r < repeat; ++r) total += measure_seconds(scan_pass);
+    report("pool_steady", total / repeat);
+
+    // 经预读流水线：读取线程借出、匹配线程归还，峰值受在途额度约束
+    total = 0.0;
+    for (int r = 0; r < repeat; ++r) {
+        total += measure_seconds([&]() {
+            FilePrefetcher prefetcher(paths);
+            PrefetchedFile file;
+            while (prefetcher.next(file)) {
+            }
+        });
+    }
+    report("pool_prefetcher", total / repeat);
+    std::cout << std::endl;
+}
+
 template <typename Fn, typename Runner>
 void print_table(const std::string& title, const std::vector<int>& thread_counts,
                  const std::vector<std::pair<std::string, Fn>>& funcs, Runner&& runner) {
@@ -124,25 +891,43 @@ void print_table(const std::string& title, const std::vector<int>& thread_counts
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Usage: ./test_performance <data_root> [repeat=3]\n";
+        std::cerr << "Usage: ./test_performance <data_root> [repeat=3] [--large <GiB>]\n";
         return 1;
     }
     std::string data_root = argv[1];
-    int repeat = (argc >= 3) ? std::stoi(argv[2]) : 3;
+    int repeat = 3;
+    size_t large_gib = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--large" && i + 1 < argc) {
+            large_gib = static_cast<size_t>(std::stoul(argv[++i]));
+        } else {
+            repeat = std::stoi(arg);
+        }
+    }
 
     std::vector<int> thread_counts = {1, 2, 4, 8, 10};
+    // 线程池按最大线程数创建，各档位的 threads 只作为并行度提示
+    configure_thread_pool(*std::max_element(thread_counts.begin(), thread_counts.end()));
+    // auto 行使用 ./myapp --calibrate 生成的配置（若存在）
+    load_tuning_config(default_tuning_path());
 
     DocData doc_data = load_doc_data(data_root);
     VirusData virus_data = load_virus_data(data_root);
 
     std::vector<std::pair<std::string, MatchFunc>> doc_funcs = {
         {"bf", match_parallel_bf}, {"kmp", match_parallel_kmp}, {"sunday", match_parallel_sunday},
-        {"rk", match_parallel_rk}, {"bm", match_parallel_bm},
+        {"rk", match_parallel_rk}, {"bm", match_parallel_bm}, {"simd", match_parallel_simd},
+        {"shift_or", match_parallel_shift_or}, {"bndm", match_parallel_bndm}, {"bom", match_parallel_bom},
+        {"two_way", match_parallel_two_way}, {"auto", match_parallel},
     };
 
     std::vector<std::pair<std::string, BinMatchFunc>> virus_funcs = {
         {"bf", binary_match_parallel_bf}, {"kmp", binary_match_parallel_kmp}, {"sunday", binary_match_parallel_sunday},
         {"rk", binary_match_parallel_rk}, {"bm", binary_match_parallel_bm},
+        {"simd", binary_match_parallel_simd}, {"shift_or", binary_match_parallel_shift_or},
+        {"bndm", binary_match_parallel_bndm}, {"bom", binary_match_parallel_bom},
+        {"two_way", binary_match_parallel_two_way}, {"auto", binary_match_parallel},
     };
 
     print_table("document retrieval", thread_counts, doc_funcs,
@@ -151,5 +936,45 @@ int main(int argc, char** argv) {
     print_table("software antivirus", thread_counts, virus_funcs,
                 [&](const BinMatchFunc& fn, int th) { return bench_virus(virus_data, fn, th, repeat); });
 
+    std::vector<std::pair<std::string, MatchAlgo>> compiled_algos = {
+        {"kmp", MatchAlgo::KMP}, {"sunday", MatchAlgo::Sunday}, {"rk", MatchAlgo::RK},
+        {"bm", MatchAlgo::BM},   {"simd", MatchAlgo::SIMD}, {"shift_or", MatchAlgo::ShiftOr},
+        {"bndm", MatchAlgo::BNDM}, {"bom", MatchAlgo::BOM}, {"two_way", MatchAlgo::TwoWay}, {"auto", MatchAlgo::Auto},
+    };
+
+    print_table("software antivirus (precompiled patterns, exists mode)", thread_counts, compiled_algos,
+                [&](const MatchAlgo& algo, int th) { return bench_virus_compiled(virus_data, algo, th, repeat); });
+    bench_signature_engines(virus_data, thread_counts, repeat);
+
+    // 分块大小扫描：跳跃长度波动大的 BM/Sunday 最能体现动态调度的尾延迟差异
+    std::vector<size_t> chunk_sizes = {64 << 10, 256 << 10, 1 << 20, 2 << 20, 8 << 20};
+    std::vector<std::pair<std::string, MatchFunc>> sweep_funcs = {
+        {"sunday", match_parallel_sunday},
+        {"bm", match_parallel_bm},
+    };
+    print_chunk_sweep(doc_data, chunk_sizes, thread_counts.back(), sweep_funcs, repeat);
+
+    std::vector<std::pair<std::string, MatchAlgo>> stream_algos = {
+        {"sunday", MatchAlgo::Sunday},
+        {"simd", MatchAlgo::SIMD},
+    };
+    bench_stream(doc_data, {4 << 10, 64 << 10, 1 << 20}, stream_algos, repeat);
+
+    bench_doc_index(doc_data, thread_counts, repeat);
+
+    bench_result_writer(doc_data, thread_counts, repeat);
+    bench_crlf(doc_data, thread_counts, repeat);
+    bench_tiled(doc_data, thread_counts, repeat);
+    bench_batch(doc_data, thread_counts, repeat);
+    bench_worst_case(repeat);
+
+    bench_virus_pipeline(data_root, thread_counts, repeat);
+    bench_batch_reader(data_root, repeat);
+    bench_buffer_pool(data_root, repeat);
+
+    if (large_gib > 0) {
+        bench_large(large_gib, thread_counts);
+    }
+
     return 0;
 }